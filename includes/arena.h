@@ -0,0 +1,38 @@
+#ifndef ASCII_VIDEO_ARENA
+#define ASCII_VIDEO_ARENA
+#include <stddef.h>
+
+#define FRAME_ARENA_INITIAL_CAPACITY (256 * 1024)
+#define FRAME_ARENA_ALIGNMENT 16
+
+typedef struct FrameArenaBlock {
+    struct FrameArenaBlock* next;
+    size_t size;
+} FrameArenaBlock;
+
+typedef struct FrameArenaStats {
+    size_t bytes;
+    unsigned long allocs;
+    unsigned long system_allocs;
+} FrameArenaStats;
+
+typedef struct FrameArena {
+    unsigned char* data;
+    size_t capacity;
+    size_t used;
+    FrameArenaBlock* overflow;
+    size_t overflow_bytes;
+    FrameArenaStats frame;
+    FrameArenaStats last_frame;
+    unsigned long nb_frames;
+} FrameArena;
+
+FrameArena* frame_arena_alloc(size_t capacity);
+void frame_arena_free(FrameArena* arena);
+void* frame_arena_push(FrameArena* arena, size_t size);
+void frame_arena_reset(FrameArena* arena);
+
+FrameArena* frame_arena_bind(FrameArena* arena);
+void* frame_arena_malloc(size_t size, FrameArena** owner);
+void frame_arena_release(void* ptr, FrameArena* owner);
+#endif
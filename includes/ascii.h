@@ -3,41 +3,59 @@
 #include <stdint.h>
 #include "macros.h"
 #include "image.h"
+#include "contrast.h"
 
 #include <libavutil/frame.h>
 
-// const std::string value_characters = "@MBHENR#KWXDFPQASUZbdehx*8Gm&04LOVYkpq5Tagns69owz$CIu23Jcfry\%1v7l+it[]{}?j|()=~!-/<>\"^_';,:`.";
-// const std::string value_characters = "█▉▊▋▌▍▎▏";
-// const std::string value_characters = "░▒▓";
+#define NB_GLYPH_RAMPS 4
+#define GLYPH_RAMP_MAX_GLYPHS 128
+#define GLYPH_MAX_BYTES 4
+#define GLYPH_NONE 255
 
-
-typedef struct ColorChar {
-    char ch;
-    rgb color;
-} ColorChar;
+typedef struct GlyphRamp {
+    const char* name;
+    int nb_glyphs;
+    int single_byte;
+    uint8_t blank;
+    char glyphs[GLYPH_RAMP_MAX_GLYPHS][GLYPH_MAX_BYTES + 1];
+    uint8_t value_to_glyph[256];
+    uint8_t glyph_to_value[GLYPH_RAMP_MAX_GLYPHS];
+} GlyphRamp;
 
 typedef struct AsciiImage {
-    char* lines;
+    uint8_t* glyphs;
+    const GlyphRamp* ramp;
     rgb* color_data;
     int colored;
     int width;
     int height;
+    FrameArena* arena;
 } AsciiImage;
 
+void init_glyph_ramps();
+const GlyphRamp* get_glyph_ramp(const char* name);
+const GlyphRamp* get_active_glyph_ramp();
+int set_active_glyph_ramp(const char* name);
+const char* get_glyph_ramp_name(int index);
 
 AsciiImage* ascii_image_alloc(int width, int height, int colored);
 void ascii_image_free(AsciiImage* image);
 AsciiImage* copy_ascii_image(AsciiImage* src);
 AsciiImage* get_ascii_image(uint8_t* pixels, int srcWidth, int srcHeight, int outputWidth, int outputHeight, PixelDataFormat format);
 AsciiImage* get_ascii_image_bounded(PixelData* pixelData, int maxWidth, int maxHeight);
+AsciiImage* get_ascii_image_equalized(PixelData* pixelData, int maxWidth, int maxHeight, ContrastEqualizer* equalizer);
 AsciiImage* get_ascii_image_from_frame(AVFrame* videoFrame, int maxWidth, int maxHeight);
+PixelData* get_pixel_data_reduced(PixelData* pixelData, int outputWidth, int outputHeight);
+const char* ascii_image_glyph(AsciiImage* image, int index);
 
-char get_char_from_value(uint8_t value);
-char get_char_from_area(uint8_t* pixels, int x, int y, int width, int height, int pixelWidth, int pixelHeight );
+uint8_t get_glyph_from_value(uint8_t value);
+uint8_t get_glyph_from_area(uint8_t* pixels, int x, int y, int width, int height, int pixelWidth, int pixelHeight);
 
-char get_char_from_rgb(rgb values);
-char get_char_from_area_rgb(uint8_t* pixels, int x, int y, int width, int height, int pixelWidth, int pixelHeight);
+uint8_t get_glyph_from_rgb(rgb values);
+uint8_t get_glyph_from_area_rgb(uint8_t* pixels, int x, int y, int width, int height, int pixelWidth, int pixelHeight);
 
+uint8_t get_avg_value_from_area(uint8_t* pixels, int x, int y, int width, int height, int pixelWidth, int pixelHeight);
+uint8_t get_avg_luma_from_area_rgb(uint8_t* pixels, int x, int y, int width, int height, int pixelWidth, int pixelHeight);
 void get_avg_color_from_area_rgb(uint8_t* pixels, int x, int y, int width, int height, int pixelWidth, int pixelHeight, rgb output);
 
 void get_output_size(int srcWidth, int srcHeight, int maxWidth, int maxHeight, int* width, int* height);
@@ -45,5 +63,5 @@ void get_scale_size(int srcWidth, int srcHeight, int targetWidth, int targetHeig
 void overlap_ascii_images(AsciiImage* first, AsciiImage* second);
 int ascii_fill_color(AsciiImage* image, rgb color);
 int ascii_init_color(AsciiImage* image);
-int get_rgb_from_char(rgb output, char ch);
+void get_rgb_from_glyph(rgb output, const GlyphRamp* ramp, uint8_t glyph);
 #endif
@@ -16,6 +16,9 @@ float** alterAudioSampleLength(float** originalSamples, int linesize[8], int nb_
 float** stretchAudioSamples(float** originalSamples, int linesize[8], int nb_samples, int nb_channels, int target_nb_samples);
 float** shrinkAudioSamples(float** originalSamples, int linesize[8], int nb_samples, int nb_channels, int target_nb_samples);
 
+typedef struct AudioStream AudioStream;
+int decode_audio_packet_into_stream(AVCodecContext* audioCodecContext, SwrContext* resampler, AVPacket* packet, AVFrame* decodeFrame, AudioStream* audioStream);
+
 uint8_t float_sample_to_uint8(float num);
 float uint8_sample_to_float(uint8_t sample);
 #endif
@@ -0,0 +1,15 @@
+#ifndef ASCII_VIDEO_BENCHMARK
+#define ASCII_VIDEO_BENCHMARK
+
+#define BENCHMARK_AUDIO_FRAMES 4096
+#define BENCHMARK_AUDIO_CHANNELS 2
+#define BENCHMARK_AUDIO_ITERATIONS 5000
+#define BENCHMARK_IMAGE_WIDTH 256
+#define BENCHMARK_IMAGE_HEIGHT 144
+#define BENCHMARK_IMAGE_ITERATIONS 200
+#define BENCHMARK_SIXEL_SCALE 4
+
+int run_benchmarks();
+void benchmark_sample_conversion();
+void benchmark_graphics_encoders();
+#endif
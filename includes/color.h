@@ -7,6 +7,8 @@ typedef int rgb_i32[3];
 
 int get_closest_color_pair(rgb input);
 int get_closest_color(rgb input);
+int get_lazy_color_pair(int fg, int bg);
+void reset_lazy_color_pairs();
 int get_most_common_colors(rgb* output, int k, rgb* colors, int nb_colors, int* actual_output_size);
 
 int find_best_initialized_color_pair(rgb input);
@@ -0,0 +1,20 @@
+#ifndef ASCII_VIDEO_CONTRAST
+#define ASCII_VIDEO_CONTRAST
+#include <stdint.h>
+
+#define LUMA_HISTOGRAM_BINS 256
+#define CONTRAST_SMOOTHING 0.15
+#define CONTRAST_CLIP_LIMIT 3.0
+
+typedef struct ContrastEqualizer {
+    double cdf[LUMA_HISTOGRAM_BINS];
+    uint8_t lut[LUMA_HISTOGRAM_BINS];
+    int primed;
+    unsigned long nb_frames;
+} ContrastEqualizer;
+
+void contrast_equalizer_init(ContrastEqualizer* equalizer);
+void contrast_equalizer_reset(ContrastEqualizer* equalizer);
+void contrast_equalizer_update(ContrastEqualizer* equalizer, const uint32_t* histogram, int nb_samples);
+void contrast_equalizer_compose(ContrastEqualizer* equalizer, const uint8_t* value_lut, uint8_t* output);
+#endif
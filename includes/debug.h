@@ -1,6 +1,7 @@
 #ifndef ASCII_VIDEO_DEBUG
 #define ASCII_VIDEO_DEBUG
 #include "boiler.h"
+#include "sync.h"
 
 #define MEDIA_DEBUG_MESSAGE_BUFFER_SIZE 1000
 
@@ -17,6 +18,7 @@ typedef struct DebugMessage {
 typedef struct media_debug_info {
     DebugMessage* messages[MEDIA_DEBUG_MESSAGE_BUFFER_SIZE];
     int nb_messages;
+    TrackedMutex lock;
 } MediaDebugInfo;
 
 void add_debug_message(MediaDebugInfo* debug_info, const char* message_source, const char* message_type, const char* message_desc, const char* format, ...);
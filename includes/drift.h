@@ -0,0 +1,33 @@
+#ifndef ASCII_VIDEO_DRIFT
+#define ASCII_VIDEO_DRIFT
+
+#define AUDIO_DRIFT_DEADBAND_SECONDS 0.005
+#define AUDIO_DRIFT_SMOOTHING 0.2
+#define AUDIO_DRIFT_MAX_RATIO 0.005
+#define AUDIO_DRIFT_COMPENSATION_SECONDS 1.0
+#define AUDIO_DRIFT_HISTORY_LENGTH 64
+#define AUDIO_DRIFT_SAMPLE_INTERVAL_SECONDS 0.25
+#define AUDIO_DRIFT_PLOT_ROWS 5
+#define AUDIO_DRIFT_PLOT_RANGE_SECONDS 0.02
+#define AUDIO_DRIFT_PLOT_BUFFER_SIZE 1024
+
+typedef struct DriftController {
+    double drift;
+    double measured;
+    int sample_delta;
+    int compensation_distance;
+    double last_compensation_time;
+    unsigned long nb_hard_resyncs;
+
+    double history[AUDIO_DRIFT_HISTORY_LENGTH];
+    int history_head;
+    int history_length;
+    double last_history_time;
+} DriftController;
+
+void drift_controller_init(DriftController* controller);
+void drift_controller_reset(DriftController* controller);
+int drift_controller_update(DriftController* controller, double measured_drift, double current_time);
+int drift_controller_compensation(DriftController* controller, int sample_rate, double current_time, int* sample_delta, int* compensation_distance);
+int drift_controller_format(DriftController* controller, char* buffer, int buffer_size);
+#endif
@@ -0,0 +1,50 @@
+#ifndef ASCII_VIDEO_FFT
+#define ASCII_VIDEO_FFT
+#include <stddef.h>
+
+#define SPECTRUM_FFT_SIZE 2048
+#define SPECTRUM_HOP_SIZE 1024
+#define SPECTRUM_NB_BANDS 64
+#define SPECTRUM_HISTORY_LENGTH 64
+#define SPECTRUM_MIN_FREQUENCY 30.0
+#define SPECTRUM_FLOOR_DB -90.0f
+#define SPECTRUM_DECAY_DB_PER_HOP 3.0f
+
+typedef struct RealFFT {
+    int size;
+    int* bit_reverse;
+    float* twiddle_re;
+    float* twiddle_im;
+    float* split_re;
+    float* split_im;
+    float* window;
+    float* re;
+    float* im;
+} RealFFT;
+
+typedef struct SpectrumAnalyzer {
+    RealFFT* fft;
+    float* input;
+    float* magnitudes;
+    float pending_bands[SPECTRUM_NB_BANDS];
+    int band_start[SPECTRUM_NB_BANDS + 1];
+    int sample_rate;
+    int enabled;
+    size_t last_position;
+
+    float bands[SPECTRUM_NB_BANDS];
+    float history[SPECTRUM_HISTORY_LENGTH][SPECTRUM_NB_BANDS];
+    int history_head;
+    unsigned long nb_hops;
+} SpectrumAnalyzer;
+
+RealFFT* real_fft_alloc(int size);
+void real_fft_free(RealFFT* fft);
+void real_fft_magnitudes(RealFFT* fft, const float* input, float* magnitudes);
+
+SpectrumAnalyzer* spectrum_analyzer_alloc();
+void spectrum_analyzer_free(SpectrumAnalyzer* analyzer);
+void spectrum_analyzer_configure(SpectrumAnalyzer* analyzer, int sample_rate);
+void spectrum_analyzer_process(SpectrumAnalyzer* analyzer);
+void spectrum_analyzer_publish(SpectrumAnalyzer* analyzer);
+#endif
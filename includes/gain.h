@@ -0,0 +1,32 @@
+#ifndef ASCII_VIDEO_GAIN
+#define ASCII_VIDEO_GAIN
+
+#define GAIN_RAMP_SECONDS 0.01
+#define AUDIO_METER_PEAK_HOLD_SECONDS 1.5
+
+typedef struct AudioMeter {
+    float peak;
+    float peak_hold;
+    double peak_hold_time;
+    unsigned long clipped_samples;
+    unsigned long nb_blocks;
+} AudioMeter;
+
+typedef struct GainStage {
+    float current;
+    float target;
+    float step;
+    int ramp_frames;
+    int ramp_remaining;
+} GainStage;
+
+void gain_stage_init(GainStage* stage, float gain, int sample_rate);
+void gain_stage_set_target(GainStage* stage, float target);
+int gain_stage_ramp(GainStage* stage, float* samples, int nb_frames, int nb_channels, float* peak, int* nb_clipped);
+float gain_block(float* samples, int nb_samples, float gain, int* nb_clipped);
+
+void audio_meter_init(AudioMeter* meter);
+void audio_meter_update(AudioMeter* meter, float block_peak, int block_clipped);
+double audio_meter_peak_dbfs(AudioMeter* meter);
+double audio_meter_hold_dbfs(AudioMeter* meter);
+#endif
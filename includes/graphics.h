@@ -0,0 +1,43 @@
+#ifndef ASCII_VIDEO_GRAPHICS
+#define ASCII_VIDEO_GRAPHICS
+#include <stddef.h>
+#include <stdint.h>
+#include "pixeldata.h"
+
+#define GRAPHICS_PROBE_TIMEOUT_MILLISECONDS 250
+#define GRAPHICS_DEFAULT_CELL_WIDTH 8
+#define GRAPHICS_DEFAULT_CELL_HEIGHT 16
+#define GRAPHICS_BUFFER_INITIAL_CAPACITY 65536
+#define SIXEL_PALETTE_SIDE 6
+#define SIXEL_PALETTE_SIZE (SIXEL_PALETTE_SIDE * SIXEL_PALETTE_SIDE * SIXEL_PALETTE_SIDE)
+#define SIXEL_BAND_HEIGHT 6
+#define KITTY_CHUNK_BYTES 4096
+#define KITTY_IMAGE_ID 1
+
+typedef enum GraphicsProtocol {
+    GRAPHICS_PROTOCOL_NONE, GRAPHICS_PROTOCOL_SIXEL, GRAPHICS_PROTOCOL_KITTY
+} GraphicsProtocol;
+
+typedef struct GraphicsBuffer {
+    char* data;
+    size_t size;
+    size_t capacity;
+    uint8_t* scratch;
+    size_t scratch_capacity;
+} GraphicsBuffer;
+
+GraphicsProtocol probe_graphics_protocol();
+const char* graphics_protocol_string(GraphicsProtocol protocol);
+void get_terminal_cell_pixel_size(int* width, int* height);
+
+GraphicsBuffer* graphics_buffer_alloc();
+void graphics_buffer_free(GraphicsBuffer* buffer);
+int graphics_buffer_append(GraphicsBuffer* buffer, const char* data, size_t size);
+int graphics_buffer_printf(GraphicsBuffer* buffer, const char* format, ...);
+uint8_t* graphics_buffer_scratch(GraphicsBuffer* buffer, size_t size);
+
+int encode_sixel_image(GraphicsBuffer* buffer, PixelData* pixelData, int scale);
+int encode_kitty_image(GraphicsBuffer* buffer, PixelData* pixelData, int columns, int rows);
+void write_graphics_image(GraphicsBuffer* buffer, int y, int x);
+void clear_graphics_images(GraphicsProtocol protocol);
+#endif
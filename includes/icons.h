@@ -1,6 +1,7 @@
 #ifndef ASCII_VIDEO_ICONS
 #define ASCII_VIDEO_ICONS
 #include "image.h"
+#include "ascii.h"
 #include <time.h>
 
 #define ICONS_SPRITE_WIDTH 16
@@ -24,7 +25,11 @@
 #define NUMBER_ICONS_PATH "assets/video Numbers.jpg"
 #define NUMBER_SYMBOLS_ICONS_PATH "assets/video Number Symbols.jpg"
 
+#define NUMBER_OF_VIDEO_ICONS 27
+#define ICON_ATLAS_NB_SIZES 3
+
 #define VIDEO_SYMBOL_BUFFER_SIZE 10
+#define OVERLAY_CACHE_SIZE 16
 
 typedef enum VideoIcon {
     STOP_ICON, PLAY_ICON, PAUSE_ICON, FORWARD_ICON, BACKWARD_ICON, MUTE_ICON, NO_VOLUME_ICON, LOW_VOLUME_ICON, MEDIUM_VOLUME_ICON, HIGH_VOLUME_ICON, MAXIMIZED_ICON, MINIMIZED_ICON, ZERO_ICON, ONE_ICON, TWO_ICON, THREE_ICON, FOUR_ICON, FIVE_ICON, SIX_ICON, SEVEN_ICON, EIGHT_ICON, NINE_ICON, POINT_ICON, TIMES_ICON, DIVIDE_ICON, PLUS_ICON, MINUS_ICON
@@ -37,11 +42,13 @@ typedef struct VideoSymbol {
     PixelData** frameData;
 } VideoSymbol;
 
+extern PixelData icon_atlas[NUMBER_OF_VIDEO_ICONS][ICON_ATLAS_NB_SIZES];
+
 int testIconProgram();
 int init_icons();
 int free_icons();
-int read_sprite_sheet(PixelData** buffer, int bufferSize, PixelData* iconData, int rows, int cols, int spriteWidth, int spriteHeight);
 PixelData* get_video_icon(VideoIcon iconEnum);
+PixelData* get_video_icon_fitted(PixelData* icon, int maxWidth, int maxHeight);
 VideoSymbol* get_video_symbol(VideoIcon iconEnum);
 VideoSymbol* get_symbol_from_volume(double normalizedVolume);
 VideoSymbol* copy_video_symbol(VideoSymbol* original);
@@ -61,8 +68,27 @@ void video_symbol_stack_erase_pop(VideoSymbolStack* stack);
 VideoSymbol* video_symbol_stack_peek(VideoSymbolStack* stack);
 void video_symbol_stack_clear(VideoSymbolStack* stack);
 
-PixelData* get_playback_icons_pixel_data();
-PixelData* get_number_icons_pixel_data(); 
-PixelData* get_number_symbols_icons_pixel_data(); 
-PixelData* get_numbers_image(int* digits, int count);
+typedef struct OverlayCacheEntry {
+    PixelData* source;
+    int max_width;
+    int max_height;
+    int colored;
+    const GlyphRamp* ramp;
+    AsciiImage* image;
+    unsigned long last_used;
+} OverlayCacheEntry;
+
+typedef struct OverlayCache {
+    OverlayCacheEntry entries[OVERLAY_CACHE_SIZE];
+    int nb_entries;
+    unsigned long clock;
+    unsigned long nb_hits;
+    unsigned long nb_misses;
+} OverlayCache;
+
+OverlayCache* overlay_cache_alloc();
+void overlay_cache_free(OverlayCache* cache);
+void overlay_cache_clear(OverlayCache* cache);
+AsciiImage* overlay_cache_get(OverlayCache* cache, PixelData* source, int maxWidth, int maxHeight, int colored);
+
 #endif
@@ -0,0 +1,27 @@
+#ifndef ASCII_VIDEO_INTEGRAL
+#define ASCII_VIDEO_INTEGRAL
+#include <stdint.h>
+#include "pixeldata.h"
+#include "color.h"
+#include "arena.h"
+
+#define INTEGRAL_IMAGE_MAX_PIXELS (UINT32_MAX / 255)
+
+typedef struct IntegralImage {
+    uint32_t* luma;
+    uint32_t* color;
+    int width;
+    int height;
+    int stride;
+    PixelDataFormat format;
+    FrameArena* arena;
+} IntegralImage;
+
+IntegralImage* integral_image_alloc(uint8_t* pixels, int width, int height, PixelDataFormat format);
+IntegralImage* integral_image_alloc_from_pixel_data(PixelData* pixelData);
+void integral_image_free(IntegralImage* integral);
+
+void integral_image_cell_span(int index, int count, int size, int* start, int* end);
+uint8_t integral_image_avg_luma(IntegralImage* integral, int x0, int y0, int x1, int y1);
+void integral_image_avg_rgb(IntegralImage* integral, int x0, int y0, int x1, int y1, rgb output);
+#endif
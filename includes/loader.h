@@ -3,4 +3,9 @@
 #include <media.h>
 
 void fetch_next(MediaData* media_data, int requestedPacketCount);
+int seek_media_data(MediaData* media_data, double target_time);
+void fetch_until(MediaData* media_data, MediaStream* stream, double target_time);
+void wake_loader_if_starved(MediaData* media_data, MediaStream* stream, PlayerState* state);
+void read_latency_histogram_init(ReadLatencyHistogram* histogram);
+void read_latency_histogram_add(ReadLatencyHistogram* histogram, double seconds);
 #endif
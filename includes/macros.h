@@ -5,13 +5,38 @@
 #define SECONDS_TO_MILLISECONDS 1000
 #define MILLISECONDS_TO_NANOSECONDS SECONDS_TO_NANOSECONDS / SECONDS_TO_MILLISECONDS
 
-#define PACKET_RESERVE_SIZE 100000
 #define VOLUME_CHANGE_AMOUNT 0.05
 #define TIME_CHANGE_AMOUNT 10
+#define JUMP_KEYFRAME_SEARCH_SECONDS 30
 #define TIME_CHANGE_WAIT_MILLISECONDS 25
 #define PLAYBACK_SPEED_CHANGE_WAIT_MILLISECONDS 250
 #define PLAYBACK_SPEED_CHANGE_INTERVAL 0.25
 
+#define AUDIO_THREAD_WAIT_MILLISECONDS 3
+#define AUDIO_STARVED_WAIT_MILLISECONDS 20
+#define AUDIO_LOOKAHEAD_SECONDS 0.5
+#define AUDIO_LOW_WATERMARK_SECONDS 0.2
+#define AUDIO_MAX_BATCH_PACKETS 64
+#define AUDIO_STREAM_WINDOW_SECONDS 4.0
+#define AUDIO_STREAM_HISTORY_SECONDS 0.5
+#define AUDIO_PREDECODE_DEFAULT_MAX_SECONDS 600.0
+#define LOADER_WAIT_MILLISECONDS 30
+#define LOADER_BATCH_PACKETS 64
+#define LOADER_REPORT_INTERVAL_SECONDS 0.5
+#define AUDIO_STATUS_REFRESH_MILLISECONDS 250
+#define AUDIO_VIEW_DEFAULT_SAMPLES 16384
+#define AUDIO_VIEW_MAX_SAMPLES ((size_t)1 << 30)
+#define LOADER_LOW_WATERMARK_SECONDS 5.0
+#define LOADER_HIGH_WATERMARK_SECONDS 20.0
+#define LOADER_LOW_WATERMARK_BYTES (4L * 1024 * 1024)
+#define LOADER_HIGH_WATERMARK_BYTES (32L * 1024 * 1024)
+#define LOADER_KEEP_BEHIND_SECONDS 45.0
+#define LOADER_KEEP_BEHIND_BYTES (16L * 1024 * 1024)
+#define RENDER_PLAYING_INPUT_TIMEOUT_MILLISECONDS 5
+#define RENDER_SYMBOL_INPUT_TIMEOUT_MILLISECONDS 100
+#define RENDER_PAUSED_INPUT_TIMEOUT_MILLISECONDS 500
+#define MAX_TRACKED_LOCKS 16
+
 /* #define MAX_ASCII_IMAGE_WIDTH (long)16 * 16 */
 /* #define MAX_ASCII_IMAGE_HEIGHT (long)9 * 16 */
 /* #define FRAME_DATA_SIZE MAX_ASCII_IMAGE_WIDTH * MAX_ASCII_IMAGE_HEIGHT */
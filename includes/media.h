@@ -6,6 +6,12 @@
 #include "debug.h"
 #include "selectionlist.h"
 #include "color.h"
+#include "gain.h"
+#include "sync.h"
+#include "waveform.h"
+#include "fft.h"
+#include "graphics.h"
+#include "contrast.h"
 
 #include <stdint.h>
 
@@ -18,26 +24,46 @@ typedef struct MediaStream {
     SelectionList* packets;
     double timeBase;
     decoder_function decodePacket;
+    TrackedMutex lock;
+    int64_t last_pts;
+    size_t total_bytes;
+    int front_trimmed;
+    int disabled;
+    _Atomic int predecoded;
 } MediaStream;
 
 
 typedef struct Playback {
-    int playing;
+    _Atomic int playing;
     double speed;
     double volume;
     double start_time;
     double paused_time;
+    double paused_at;
     double skipped_time;
+    TrackedMutex lock;
 } Playback;
 
+#define READ_LATENCY_HISTOGRAM_BUCKETS 20
+typedef struct ReadLatencyHistogram {
+    unsigned long buckets[READ_LATENCY_HISTOGRAM_BUCKETS];
+    unsigned long nb_reads;
+    double total_time;
+    double max_time;
+} ReadLatencyHistogram;
+
 typedef struct MediaData {
     AVFormatContext* formatContext;
     MediaStream** media_streams;
     int nb_streams;
-    int allPacketsRead;
+    _Atomic int allPacketsRead;
+    _Atomic int loaderWaiting;
+    _Atomic unsigned long seek_generation;
     int currentPacket;
     int totalPackets;
     double duration;
+    TrackedMutex demux_lock;
+    ReadLatencyHistogram read_latency;
 } MediaData;
 
 typedef struct MediaTimeline {
@@ -45,14 +71,30 @@ typedef struct MediaTimeline {
     Playback* playback;
 } MediaTimeline;
 
-#define NUMBER_OF_DISPLAY_MODES 2
+#define NUMBER_OF_DISPLAY_MODES 3
 typedef enum MediaDisplayMode {
-    DISPLAY_MODE_VIDEO, DISPLAY_MODE_AUDIO
+    DISPLAY_MODE_VIDEO, DISPLAY_MODE_AUDIO, DISPLAY_MODE_SPECTRUM
 } MediaDisplayMode;
 MediaDisplayMode get_next_display_mode(MediaDisplayMode currentMode);
 
+typedef enum RenderMethod {
+    RENDER_METHOD_ASCII, RENDER_METHOD_HALF_BLOCK, RENDER_METHOD_BRAILLE, RENDER_METHOD_GRAPHICS
+} RenderMethod;
+
+typedef struct DisplayGeometry {
+    int columns;
+    int rows;
+    RenderMethod method;
+    int frame_width;
+    int frame_height;
+} DisplayGeometry;
+
 typedef struct MediaDisplaySettings {
     int subtitles;
+    RenderMethod render_method;
+    int dither;
+    GraphicsProtocol graphics_protocol;
+    int equalize;
 
     int use_colors;
     int can_use_colors;
@@ -63,6 +105,18 @@ typedef struct MediaDisplaySettings {
     rgb* best_palette;
 } MediaDisplaySettings; 
 
+typedef enum AudioPerformanceProfile {
+    AUDIO_PROFILE_LOW_LATENCY, AUDIO_PROFILE_CONSERVATIVE
+} AudioPerformanceProfile;
+
+typedef struct MediaAudioSettings {
+    int period_size_frames;
+    int periods;
+    AudioPerformanceProfile profile;
+    double predecode_max_seconds;
+    int predecode_to_file;
+} MediaAudioSettings;
+
 typedef struct AudioStream {
     uint8_t* stream;
     float start_time;
@@ -71,6 +125,15 @@ typedef struct AudioStream {
     size_t sample_capacity;
     int nb_channels;
     int sample_rate;
+    WaveformEnvelope* envelope;
+    TrackedMutex envelope_lock;
+    size_t trimmed_samples;
+    int complete;
+    int backing_fd;
+    size_t mapped_bytes;
+    double read_rate;
+    double read_phase;
+    TrackedMutex lock;
 } AudioStream;
 
 typedef struct Sample {
@@ -80,21 +143,38 @@ typedef struct Sample {
 
 typedef struct MediaDisplayCache {
     MediaDebugInfo* debug_info;
+    TrackedMutex lock;
     PixelData* image;
     PixelData* last_rendered_image;
     SelectionList* image_buffer;
 
     AudioStream* audio_stream;
+    AudioMeter audio_meter;
+    SpectrumAnalyzer* spectrum;
+    ContrastEqualizer equalizer;
+
+    GraphicsBuffer* graphics_buffer;
+    int graphics_visible;
+    size_t graphics_frame_bytes;
+    double graphics_encode_time;
+    int graphics_columns;
+    int graphics_rows;
+    DisplayGeometry geometry;
+    _Atomic unsigned long geometry_generation;
 
     VideoSymbolStack* symbol_stack;
+    OverlayCache* overlay_cache;
+    FrameArena* frame_arena;
 } MediaDisplayCache;
 
 typedef struct MediaPlayer {
     MediaTimeline* timeline;
     MediaDisplaySettings* displaySettings;
+    MediaAudioSettings* audioSettings;
     MediaDisplayCache* displayCache;
+    PlayerState* state;
     const char* fileName;
-    int inUse;
+    _Atomic int inUse;
 } MediaPlayer;
 
 /* typedef struct ThreadPriveliges { */
@@ -106,6 +186,7 @@ void media_player_free(MediaPlayer* player);
 
 int start_media_player(MediaPlayer* player);
 int start_media_player_from_filename(const char* fileName);
+int start_audio_player(MediaPlayer* player);
 
 MediaDisplayCache* media_display_cache_alloc();
 void media_display_cache_free(MediaDisplayCache* cache);
@@ -113,6 +194,9 @@ void media_display_cache_free(MediaDisplayCache* cache);
 MediaDisplaySettings* media_display_settings_alloc();
 void media_display_settings_free(MediaDisplaySettings* settings);
 
+MediaAudioSettings* media_audio_settings_alloc();
+void media_audio_settings_free(MediaAudioSettings* settings);
+
 MediaTimeline* media_timeline_alloc(const char* fileName);
 void media_timeline_free(MediaTimeline* timeline);
 
@@ -121,21 +205,40 @@ void media_data_free(MediaData* mediaData);
 
 MediaStream* media_stream_alloc(StreamData* streamData);
 void media_stream_free(MediaStream* mediaStream);
+double media_stream_buffered_seconds(MediaStream* stream);
+size_t media_stream_buffered_bytes(MediaStream* stream);
+double media_stream_buffered_end_time(MediaStream* stream);
+double media_stream_buffered_start_time(MediaStream* stream);
+void media_stream_trim(MediaStream* stream);
+void media_stream_clear_packets(MediaStream* stream);
+int media_stream_is_discarded(MediaStream* stream);
 
 Playback* playback_alloc();
 void playback_free(Playback* playback);
 double get_playback_current_time(Playback* playback);
+void playback_skip_time(Playback* playback, double seconds);
+void playback_set_playing(Playback* playback, int playing);
+void playback_toggle_playing(Playback* playback);
 
 AudioStream* audio_stream_alloc();
 void audio_stream_free(AudioStream* stream);
 int audio_stream_init(AudioStream* stream, int nb_channels, int initial_size, int sample_rate);
-int audio_stream_clear(AudioStream* stream, int cleared_capacity);
+int audio_stream_clear(AudioStream* stream);
+void audio_stream_trim(AudioStream* stream, size_t keep_behind);
+int audio_stream_reserve(AudioStream* stream, size_t nb_samples);
+int audio_stream_map_temp_file(AudioStream* stream);
+void audio_stream_adopt(AudioStream* stream, AudioStream* source);
+void audio_stream_release_buffer(AudioStream* stream);
 double audio_stream_time(AudioStream* stream);
 double audio_stream_end_time(AudioStream* stream);
+double audio_stream_buffered_seconds(AudioStream* stream);
+size_t audio_stream_start_sample(AudioStream* stream);
+double audio_stream_buffered_start_time(AudioStream* stream);
 double audio_stream_set_time(AudioStream* stream, double time);
 
 MediaStream* get_media_stream(MediaData* media_data, enum AVMediaType media_type);
 int has_media_stream(MediaData* media_data, enum AVMediaType media_type);
+int get_media_player_locks(MediaPlayer* player, TrackedMutex** locks, int max_locks);
 
 void move_packet_list_to_pts(SelectionList* packets, int64_t targetPTS);
 void move_frame_list_to_pts(SelectionList* frames, int64_t targetPTS);
@@ -1,6 +1,7 @@
 #ifndef ASCII_VIDEO_PIXEL_DATA
 #define ASCII_VIDEO_PIXEL_DATA
 #include <stdint.h>
+#include "arena.h"
 #include <libavutil/frame.h>
 #include <libavutil/pixfmt.h>
 
@@ -13,11 +14,13 @@ typedef struct PixelData {
     int width;
     int height;
     PixelDataFormat format;
+    FrameArena* arena;
 } PixelData;
 
 enum AVPixelFormat PixelDataFormat_to_AVPixelFormat(PixelDataFormat format);
 PixelDataFormat AVPixelFormat_to_PixelDataFormat(enum AVPixelFormat format);
 PixelData* copy_pixel_data(PixelData* original);
+int copy_pixel_data_into(PixelData* destination, PixelData* source);
 PixelData* pixel_data_alloc(int width, int height, PixelDataFormat);
 PixelData* pixel_data_alloc_from_frame(AVFrame* videoFrame);
 int get_pixel_data_buffer_size(PixelData* data);
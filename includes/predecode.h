@@ -0,0 +1,16 @@
+#ifndef ASCII_VIDEO_PREDECODE
+#define ASCII_VIDEO_PREDECODE
+#include <media.h>
+#include <pthread.h>
+
+typedef struct AudioPredecodeJob {
+    MediaPlayer* player;
+    pthread_t thread;
+    int started;
+} AudioPredecodeJob;
+
+int should_predecode_audio(MediaPlayer* player);
+int start_audio_predecode(AudioPredecodeJob* job, MediaPlayer* player);
+void join_audio_predecode(AudioPredecodeJob* job);
+void* audio_predecode_thread(void* args);
+#endif
@@ -6,6 +6,7 @@
 typedef struct AudioGuiData {
     int channel_index;
     int show_all_channels;
+    size_t shown_samples;
 } AudioGuiData;
 
 typedef struct VideoGuiData {
@@ -25,6 +26,7 @@ void render_movie_screen(MediaPlayer* player, GuiData gui_data);
 void render_video_debug(MediaPlayer* player, GuiData gui_data);
 void render_audio_debug(MediaPlayer* player, GuiData gui_data);
 void render_audio_screen(MediaPlayer* player, GuiData gui_data);
+void render_spectrum_screen(MediaPlayer* player);
 
 void print_ascii_image_full(AsciiImage* textImage);
 #endif
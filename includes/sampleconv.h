@@ -0,0 +1,25 @@
+#ifndef ASCII_VIDEO_SAMPLECONV
+#define ASCII_VIDEO_SAMPLECONV
+#include <stdint.h>
+
+/**
+ * Conversion kernels apply gain while converting and return the peak
+ * magnitude of what they wrote, so the callback needs no second pass for
+ * gain or metering. u8_to_f32_resampled reads interleaved frames starting
+ * phase frames into src, stepping step source frames per output frame with
+ * linear interpolation; the caller must provide
+ * (size_t)(phase + nb_frames * step) + 2 readable frames.
+ */
+typedef struct SampleConversionKernels {
+    const char* name;
+    float (*u8_to_f32)(float* dst, const uint8_t* src, int nb_samples, float gain);
+    float (*s16_to_f32)(float* dst, const int16_t* src, int nb_samples, float gain);
+    float (*f32_to_f32)(float* dst, const float* src, int nb_samples, float gain);
+    float (*u8_to_f32_resampled)(float* dst, const uint8_t* src, int nb_frames, int nb_channels, double phase, double step, float gain);
+    void (*interleave_f32)(float* dst, const float* const* src, int nb_frames, int nb_channels);
+    void (*deinterleave_f32)(float* const* dst, const float* src, int nb_frames, int nb_channels);
+} SampleConversionKernels;
+
+const SampleConversionKernels* get_sample_conversion_kernels();
+const SampleConversionKernels* get_generic_sample_conversion_kernels();
+#endif
@@ -0,0 +1,19 @@
+#ifndef ASCII_VIDEO_SUBCELL
+#define ASCII_VIDEO_SUBCELL
+#include "pixeldata.h"
+#include "color.h"
+
+#define HALF_BLOCK_CHARACTER "▀"
+#define BRAILLE_CELL_WIDTH 2
+#define BRAILLE_CELL_HEIGHT 4
+#define BRAILLE_GLYPH_BYTES 3
+#define BRAILLE_THRESHOLD 128
+#define BRAILLE_DITHER_SIZE 4
+
+void pixel_data_get_rgb(PixelData* pixelData, int x, int y, rgb output);
+void print_half_block_image(PixelData* pixelData, int y, int x);
+
+void braille_threshold_row(const uint8_t* values, int width, int row, int dither, uint8_t* mask);
+void braille_pack_row(const uint8_t* mask, int width, int dot_row, uint8_t* cells);
+void print_braille_image(PixelData* pixelData, int y, int x, int dither);
+#endif
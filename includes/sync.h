@@ -0,0 +1,55 @@
+#ifndef ASCII_VIDEO_SYNC
+#define ASCII_VIDEO_SYNC
+#include <pthread.h>
+
+#define NUMBER_OF_PLAYER_THREADS 4
+typedef enum PlayerThread {
+    PLAYER_THREAD_RENDER, PLAYER_THREAD_VIDEO, PLAYER_THREAD_AUDIO, PLAYER_THREAD_LOADER
+} PlayerThread;
+
+typedef struct TrackedMutex {
+    pthread_mutex_t mutex;
+    const char* name;
+    unsigned long acquisitions;
+    unsigned long contentions;
+    double wait_time;
+    double max_wait_time;
+} TrackedMutex;
+
+typedef struct TrackedMutexStats {
+    const char* name;
+    unsigned long acquisitions;
+    unsigned long contentions;
+    double wait_time;
+    double max_wait_time;
+} TrackedMutexStats;
+
+typedef struct PlayerState {
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+    unsigned long generation;
+
+    unsigned long wakeups[NUMBER_OF_PLAYER_THREADS];
+    unsigned long last_wakeups[NUMBER_OF_PLAYER_THREADS];
+    double wakeup_rates[NUMBER_OF_PLAYER_THREADS];
+    double last_rate_time;
+} PlayerState;
+
+PlayerState* player_state_alloc();
+void player_state_free(PlayerState* state);
+
+unsigned long player_state_generation(PlayerState* state);
+void player_state_notify(PlayerState* state);
+int player_state_wait(PlayerState* state, unsigned long seen_generation, double timeout_seconds);
+int player_state_wait_forever(PlayerState* state, unsigned long seen_generation);
+
+void player_state_count_wakeup(PlayerState* state, PlayerThread thread);
+void player_state_get_wakeup_rates(PlayerState* state, double* rates);
+const char* player_thread_name(PlayerThread thread);
+
+int tracked_mutex_init(TrackedMutex* mutex, const char* name);
+void tracked_mutex_destroy(TrackedMutex* mutex);
+void tracked_mutex_lock(TrackedMutex* mutex);
+void tracked_mutex_unlock(TrackedMutex* mutex);
+void tracked_mutex_get_stats(TrackedMutex* mutex, TrackedMutexStats* stats);
+#endif
@@ -10,7 +10,6 @@ void sleep_for_ms(long ms);
 
 typedef struct MediaThreadData {
     MediaPlayer* player;
-    pthread_mutex_t* alterMutex;
 } MediaThreadData;
 
 /* void* video_playback_thread(MediaPlayer* player, pthread_mutex_t* alterMutex); */
@@ -18,5 +17,6 @@ void* video_playback_thread(void* args);
 void* audio_playback_thread(void* args);
 void* data_loading_thread(void* args);
 /* void input_thread(void* args); */
-void render_loop(MediaPlayer* player, pthread_mutex_t* alterMutex);
+void render_loop(MediaPlayer* player);
+void audio_status_loop(MediaPlayer* player);
 #endif
@@ -1,5 +1,12 @@
 #ifndef ASCII_VIDEO_VIDEO
 #define ASCII_VIDEO_VIDEO
 #include <media.h>
+
+#define VIDEO_GRAPHICS_MAX_FRAME_WIDTH 640
+#define VIDEO_GRAPHICS_MAX_FRAME_HEIGHT 360
+
 void jump_to_time(MediaTimeline* timeline, double targetTime);
+void get_video_frame_target(int src_width, int src_height, RenderMethod method, int columns, int rows, int* width, int* height);
+void publish_display_geometry(MediaDisplayCache* cache, DisplayGeometry* geometry);
+int read_display_geometry(MediaDisplayCache* cache, unsigned long* seen_generation, DisplayGeometry* geometry);
 #endif
@@ -0,0 +1,46 @@
+#ifndef ASCII_VIDEO_WAVEFORM
+#define ASCII_VIDEO_WAVEFORM
+#include <stddef.h>
+#include <stdint.h>
+
+#define WAVEFORM_BASE_BIN_SAMPLES 64
+#define WAVEFORM_MAX_LEVELS 20
+
+typedef struct WaveformBin {
+    uint8_t min;
+    uint8_t max;
+    uint8_t rms;
+    uint8_t filled;
+} WaveformBin;
+
+typedef struct WaveformLevel {
+    WaveformBin* bins;
+    size_t nb_bins;
+    size_t capacity;
+} WaveformLevel;
+
+typedef struct WaveformEnvelope {
+    WaveformLevel levels[WAVEFORM_MAX_LEVELS];
+    int nb_channels;
+    int sample_rate;
+
+    size_t pending_position;
+    int nb_pending;
+    uint8_t* pending_min;
+    uint8_t* pending_max;
+    float* pending_squares;
+} WaveformEnvelope;
+
+typedef struct WaveformColumn {
+    float min;
+    float max;
+    float rms;
+    int filled;
+} WaveformColumn;
+
+WaveformEnvelope* waveform_envelope_alloc(int nb_channels, int sample_rate);
+void waveform_envelope_free(WaveformEnvelope* envelope);
+void waveform_envelope_append(WaveformEnvelope* envelope, size_t position, const uint8_t* samples, size_t nb_samples);
+int waveform_envelope_query(WaveformEnvelope* envelope, int channel, size_t start_sample, size_t samples_per_column, int nb_columns, WaveformColumn* output);
+void waveform_columns_from_samples(const uint8_t* samples, size_t nb_samples, int channel, int nb_channels, size_t samples_per_column, int nb_columns, WaveformColumn* output);
+#endif
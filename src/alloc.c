@@ -7,7 +7,13 @@
 #include <stdio.h>
 #include <media.h>
 #include <info.h>
+#include <loader.h>
 #include <curses.h>
+#include <macros.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 #include <libavformat/avformat.h>
 #include <libavutil/avutil.h>
@@ -26,10 +32,19 @@ MediaPlayer* media_player_alloc(const char* fileName) {
         return NULL;
     }
 
+    mediaPlayer->audioSettings = media_audio_settings_alloc();
+    if (mediaPlayer->audioSettings == NULL) {
+        fprintf(stderr, "%s\n" ,"Could not allocate media player because of error while allocating media audio settings");
+        media_display_settings_free(mediaPlayer->displaySettings);
+        free(mediaPlayer);
+        return NULL;
+    }
+
     mediaPlayer->displayCache = media_display_cache_alloc();
     if (mediaPlayer->displayCache == NULL) {
         fprintf(stderr, "%s\n" ,"Could not allocate media player because of error while allocating media display cache");
         media_display_settings_free(mediaPlayer->displaySettings);
+        media_audio_settings_free(mediaPlayer->audioSettings);
         free(mediaPlayer);
         return NULL;
     }
@@ -38,11 +53,23 @@ MediaPlayer* media_player_alloc(const char* fileName) {
     if (mediaPlayer->timeline == NULL) {
         fprintf(stderr, "%s\n" ,"Could not allocate media player because of error while allocating media timeline");
         media_display_settings_free(mediaPlayer->displaySettings);
+        media_audio_settings_free(mediaPlayer->audioSettings);
         media_display_cache_free(mediaPlayer->displayCache);
         free(mediaPlayer);
         return NULL;
     }
 
+    mediaPlayer->state = player_state_alloc();
+    if (mediaPlayer->state == NULL) {
+        fprintf(stderr, "%s\n" ,"Could not allocate media player because of error while allocating player state");
+        media_display_settings_free(mediaPlayer->displaySettings);
+        media_audio_settings_free(mediaPlayer->audioSettings);
+        media_display_cache_free(mediaPlayer->displayCache);
+        media_timeline_free(mediaPlayer->timeline);
+        free(mediaPlayer);
+        return NULL;
+    }
+
     mediaPlayer->inUse = false;
     mediaPlayer->fileName = fileName;
     return mediaPlayer;
@@ -89,7 +116,62 @@ MediaDisplayCache* media_display_cache_alloc() {
         return NULL;
     }
 
+    cache->spectrum = spectrum_analyzer_alloc();
+    if (cache->spectrum == NULL) {
+        audio_stream_free(cache->audio_stream);
+        free(cache->image_buffer);
+        media_debug_info_free(cache->debug_info);
+        video_symbol_stack_free(cache->symbol_stack);
+        free(cache);
+        return NULL;
+    }
+
+    cache->overlay_cache = overlay_cache_alloc();
+    if (cache->overlay_cache == NULL) {
+        spectrum_analyzer_free(cache->spectrum);
+        audio_stream_free(cache->audio_stream);
+        free(cache->image_buffer);
+        media_debug_info_free(cache->debug_info);
+        video_symbol_stack_free(cache->symbol_stack);
+        free(cache);
+        return NULL;
+    }
+
+    cache->frame_arena = frame_arena_alloc(FRAME_ARENA_INITIAL_CAPACITY);
+    if (cache->frame_arena == NULL) {
+        overlay_cache_free(cache->overlay_cache);
+        spectrum_analyzer_free(cache->spectrum);
+        audio_stream_free(cache->audio_stream);
+        free(cache->image_buffer);
+        media_debug_info_free(cache->debug_info);
+        video_symbol_stack_free(cache->symbol_stack);
+        free(cache);
+        return NULL;
+    }
+
+    if (!tracked_mutex_init(&cache->lock, "display cache")) {
+        frame_arena_free(cache->frame_arena);
+        overlay_cache_free(cache->overlay_cache);
+        spectrum_analyzer_free(cache->spectrum);
+        audio_stream_free(cache->audio_stream);
+        free(cache->image_buffer);
+        media_debug_info_free(cache->debug_info);
+        video_symbol_stack_free(cache->symbol_stack);
+        free(cache);
+        return NULL;
+    }
+
+    audio_meter_init(&cache->audio_meter);
+    contrast_equalizer_init(&cache->equalizer);
     cache->last_rendered_image = NULL;
+    cache->graphics_buffer = NULL;
+    cache->graphics_visible = 0;
+    cache->graphics_frame_bytes = 0;
+    cache->graphics_encode_time = 0.0;
+    cache->graphics_columns = 0;
+    cache->graphics_rows = 0;
+    cache->geometry = (DisplayGeometry){ 0, 0, RENDER_METHOD_ASCII, 0, 0 };
+    cache->geometry_generation = 0;
     return cache;
 }
 
@@ -99,12 +181,18 @@ MediaDebugInfo* media_debug_info_alloc() {
         fprintf(stderr, "%s", "Could not allocate Media Debug Info");
         return NULL;
     }
+
+    if (!tracked_mutex_init(&debug_info->lock, "debug info")) {
+        free(debug_info);
+        return NULL;
+    }
     debug_info->nb_messages = 0;
     return debug_info;
 }
 
 void media_debug_info_free(MediaDebugInfo* info) {
     clear_media_debug(info, "", "");
+    tracked_mutex_destroy(&info->lock);
     free(info);
 }
 
@@ -130,6 +218,10 @@ MediaDisplaySettings* media_display_settings_alloc() {
     settings->can_use_colors = has_colors() == TRUE ? 1 : 0;
     settings->can_change_colors = can_change_color() == TRUE ? 1 : 0;
     settings->use_colors = false;
+    settings->render_method = RENDER_METHOD_ASCII;
+    settings->dither = false;
+    settings->graphics_protocol = GRAPHICS_PROTOCOL_NONE;
+    settings->equalize = false;
 
     settings->train_palette = true;
     settings->best_palette = (rgb*)malloc(sizeof(rgb) * 16);
@@ -144,6 +236,21 @@ MediaDisplaySettings* media_display_settings_alloc() {
     return settings;
 }
 
+MediaAudioSettings* media_audio_settings_alloc() {
+    MediaAudioSettings* settings = (MediaAudioSettings*)malloc(sizeof(MediaAudioSettings));
+    if (settings == NULL) {
+        fprintf(stderr,  "%s", "Could not allocate Media Audio Settings");
+        return NULL;
+    }
+
+    settings->period_size_frames = 0;
+    settings->periods = 0;
+    settings->profile = AUDIO_PROFILE_LOW_LATENCY;
+    settings->predecode_max_seconds = AUDIO_PREDECODE_DEFAULT_MAX_SECONDS;
+    settings->predecode_to_file = 0;
+    return settings;
+}
+
 MediaTimeline* media_timeline_alloc(const char* fileName) {
     MediaTimeline* timeline = (MediaTimeline*)malloc(sizeof(MediaTimeline));
     if (timeline == NULL) {
@@ -195,7 +302,17 @@ MediaData* media_data_alloc(const char* fileName) {
         return NULL;
     }
 
+    if (!tracked_mutex_init(&mediaData->demux_lock, "demux")) {
+        avformat_free_context(mediaData->formatContext);
+        stream_datas_free(streamData, out_stream_count);
+        free(mediaData);
+        return NULL;
+    }
+
+    read_latency_histogram_init(&mediaData->read_latency);
     mediaData->allPacketsRead = false;
+    mediaData->loaderWaiting = false;
+    mediaData->seek_generation = 0;
     mediaData->currentPacket = 0;
     mediaData->totalPackets = get_num_packets(fileName);
     mediaData->nb_streams = out_stream_count;
@@ -232,6 +349,17 @@ MediaStream* media_stream_alloc(StreamData* streamData) {
         return NULL;
     }
 
+    if (!tracked_mutex_init(&mediaStream->lock, streamData->mediaType == AVMEDIA_TYPE_VIDEO ? "video stream" : "audio stream")) {
+        selection_list_free(mediaStream->packets);
+        free(mediaStream);
+        return NULL;
+    }
+
+    mediaStream->last_pts = AV_NOPTS_VALUE;
+    mediaStream->total_bytes = 0;
+    mediaStream->front_trimmed = 0;
+    mediaStream->disabled = 0;
+    mediaStream->predecoded = 0;
     mediaStream->timeBase = av_q2d(streamData->stream->time_base);
     mediaStream->decodePacket = get_stream_decoder(streamData->mediaType); 
     //TODO: STREAM DECODER FOR SUBTITLE DATA
@@ -240,8 +368,10 @@ MediaStream* media_stream_alloc(StreamData* streamData) {
 
 void media_player_free(MediaPlayer* player) {
     media_display_settings_free(player->displaySettings);
+    media_audio_settings_free(player->audioSettings);
     media_timeline_free(player->timeline);
     media_display_cache_free(player->displayCache);
+    player_state_free(player->state);
 
     free(player);
     player = NULL;
@@ -254,18 +384,25 @@ void video_symbol_stack_free(VideoSymbolStack *stack) {
 }
 
 void media_display_cache_free(MediaDisplayCache* cache) {
-    free(cache->debug_info);
+    media_debug_info_free(cache->debug_info);
+    tracked_mutex_destroy(&cache->lock);
     free(cache->image_buffer);
     video_symbol_stack_free(cache->symbol_stack);
     if (cache->image != NULL) {
-        free(cache->image);
+        pixel_data_free(cache->image);
     }
     if (cache->last_rendered_image != NULL) {
-        free(cache->last_rendered_image);
+        pixel_data_free(cache->last_rendered_image);
     }
     if (cache->audio_stream != NULL) {
         audio_stream_free(cache->audio_stream);
     }
+    spectrum_analyzer_free(cache->spectrum);
+    overlay_cache_free(cache->overlay_cache);
+    frame_arena_free(cache->frame_arena);
+    if (cache->graphics_buffer != NULL) {
+        graphics_buffer_free(cache->graphics_buffer);
+    }
 
     free(cache);
     cache = NULL;
@@ -277,6 +414,10 @@ void media_display_settings_free(MediaDisplaySettings *settings) {
     settings = NULL;
 }
 
+void media_audio_settings_free(MediaAudioSettings* settings) {
+    free(settings);
+}
+
 void media_timeline_free(MediaTimeline *timeline) {
     playback_free(timeline->playback);
     media_data_free(timeline->mediaData);
@@ -290,21 +431,34 @@ void media_data_free(MediaData* mediaData) {
     }
     avformat_close_input(&(mediaData->formatContext));
     avformat_free_context(mediaData->formatContext);
+    tracked_mutex_destroy(&mediaData->demux_lock);
     free(mediaData);
     mediaData = NULL;
 }
 
 void media_stream_free(MediaStream* mediaStream) {
+    media_stream_clear_packets(mediaStream);
     selection_list_free(mediaStream->packets);
     stream_data_free(mediaStream->info);
+    tracked_mutex_destroy(&mediaStream->lock);
     free(mediaStream);
     mediaStream = NULL;
 }
 
 Playback* playback_alloc() {
     Playback* playback = (Playback*)malloc(sizeof(Playback));
+    if (playback == NULL) {
+        return NULL;
+    }
+
+    if (!tracked_mutex_init(&playback->lock, "playback")) {
+        free(playback);
+        return NULL;
+    }
+
     playback->start_time = 0.0;
     playback->paused_time = 0.0;
+    playback->paused_at = 0.0;
     playback->skipped_time = 0.0;
     playback->speed = 1.0;
     playback->volume = 1.0;
@@ -313,6 +467,7 @@ Playback* playback_alloc() {
 }
 
 void playback_free(Playback* playback) {
+    tracked_mutex_destroy(&playback->lock);
     free(playback);
     playback = NULL;
 }
@@ -322,6 +477,17 @@ AudioStream* audio_stream_alloc() {
     if (audio_stream == NULL) {
         return NULL;
     }
+
+    if (!tracked_mutex_init(&audio_stream->lock, "audio buffer")) {
+        free(audio_stream);
+        return NULL;
+    }
+
+    if (!tracked_mutex_init(&audio_stream->envelope_lock, "waveform envelope")) {
+        tracked_mutex_destroy(&audio_stream->lock);
+        free(audio_stream);
+        return NULL;
+    }
     audio_stream->stream = NULL;
     audio_stream->playhead = 0;
     audio_stream->nb_channels = 0;
@@ -329,48 +495,205 @@ AudioStream* audio_stream_alloc() {
     audio_stream->sample_capacity = 0;
     audio_stream->nb_samples = 0;
     audio_stream->sample_rate = 0;
+    audio_stream->envelope = NULL;
+    audio_stream->trimmed_samples = 0;
+    audio_stream->complete = 0;
+    audio_stream->backing_fd = -1;
+    audio_stream->mapped_bytes = 0;
+    audio_stream->read_rate = 1.0;
+    audio_stream->read_phase = 0.0;
     return audio_stream;
 }
 
-int audio_stream_init(AudioStream* stream, int nb_channels, int initial_size, int sample_rate) {
+void audio_stream_release_buffer(AudioStream* stream) {
     if (stream->stream != NULL) {
-        free(stream->stream);
+        if (stream->backing_fd >= 0) {
+            munmap(stream->stream, stream->mapped_bytes);
+        } else {
+            free(stream->stream);
+        }
     }
 
-    stream->stream = (uint8_t*)malloc(sizeof(uint8_t) * nb_channels * initial_size * 2);
+    if (stream->backing_fd >= 0) {
+        close(stream->backing_fd);
+    }
+    stream->stream = NULL;
+    stream->backing_fd = -1;
+    stream->mapped_bytes = 0;
+}
+
+int audio_stream_init(AudioStream* stream, int nb_channels, int initial_size, int sample_rate) {
+    audio_stream_release_buffer(stream);
+
+    stream->stream = (uint8_t*)malloc(sizeof(uint8_t) * nb_channels * initial_size);
     if (stream->stream == NULL) {
         return 0;
     }
 
-    stream->sample_capacity = initial_size * 2;
+    WaveformEnvelope* envelope = waveform_envelope_alloc(nb_channels, sample_rate);
+    if (envelope == NULL) {
+        free(stream->stream);
+        stream->stream = NULL;
+        return 0;
+    }
+
+    tracked_mutex_lock(&stream->envelope_lock);
+    if (stream->envelope != NULL) {
+        waveform_envelope_free(stream->envelope);
+    }
+    stream->envelope = envelope;
+    tracked_mutex_unlock(&stream->envelope_lock);
+
+    stream->sample_capacity = initial_size;
     stream->nb_samples = 0;
     stream->nb_channels = nb_channels;
     stream->start_time = 0.0;
     stream->sample_rate = sample_rate;
     stream->playhead = 0;
+    stream->trimmed_samples = 0;
+    stream->complete = 0;
+    stream->read_rate = 1.0;
+    stream->read_phase = 0.0;
     return 1;
 }
 
-int audio_stream_clear(AudioStream* stream, int cleared_capacity) {
-    if (stream->stream != NULL) {
-        free(stream->stream);
+int audio_stream_clear(AudioStream* stream) {
+    if (stream->stream == NULL) {
+        return 0;
     }
 
-    uint8_t* tmp =  (uint8_t*)malloc(sizeof(uint8_t) * stream->nb_channels * cleared_capacity * 2);
+    stream->nb_samples = 0;
+    stream->playhead = 0;
+    stream->trimmed_samples = 0;
+    stream->read_phase = 0.0;
+    return 1;
+}
+
+void audio_stream_trim(AudioStream* stream, size_t keep_behind) {
+    if (stream->complete || stream->playhead <= keep_behind) {
+        return;
+    }
+
+    const size_t dropped = stream->playhead - keep_behind;
+    memmove(stream->stream, stream->stream + dropped * stream->nb_channels, (stream->nb_samples - dropped) * stream->nb_channels);
+    stream->nb_samples -= dropped;
+    stream->playhead -= dropped;
+    stream->trimmed_samples += dropped;
+}
+
+int audio_stream_reserve(AudioStream* stream, size_t nb_samples) {
+    size_t capacity = stream->sample_capacity > 0 ? stream->sample_capacity : nb_samples;
+    while (capacity < nb_samples) {
+        capacity *= 2;
+    }
+
+    if (capacity == stream->sample_capacity) {
+        return 1;
+    }
+
+    if (stream->backing_fd >= 0) {
+        const size_t mapped_bytes = sizeof(uint8_t) * capacity * stream->nb_channels;
+        if (ftruncate(stream->backing_fd, mapped_bytes) != 0) {
+            return 0;
+        }
+
+        uint8_t* mapped = (uint8_t*)mmap(NULL, mapped_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, stream->backing_fd, 0);
+        if (mapped == MAP_FAILED) {
+            return 0;
+        }
+
+        munmap(stream->stream, stream->mapped_bytes);
+        stream->stream = mapped;
+        stream->mapped_bytes = mapped_bytes;
+        stream->sample_capacity = capacity;
+        return 1;
+    }
+
+    uint8_t* tmp = (uint8_t*)realloc(stream->stream, sizeof(uint8_t) * capacity * stream->nb_channels);
     if (tmp == NULL) {
         return 0;
     }
+
     stream->stream = tmp;
-    stream->nb_samples = 0;
-    stream->playhead = 0;
-    stream->sample_capacity = cleared_capacity;
-    stream->playhead = 0;
+    stream->sample_capacity = capacity;
     return 1;
 }
 
+int audio_stream_map_temp_file(AudioStream* stream) {
+    char path[] = "/tmp/ascii_video_audio_XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd < 0) {
+        fprintf(stderr, "%s\n", "Could not create temporary audio file");
+        return 0;
+    }
+    unlink(path);
+
+    const size_t mapped_bytes = sizeof(uint8_t) * (stream->sample_capacity > 0 ? stream->sample_capacity : 1) * stream->nb_channels;
+    if (ftruncate(fd, mapped_bytes) != 0) {
+        fprintf(stderr, "%s\n", "Could not size temporary audio file");
+        close(fd);
+        return 0;
+    }
+
+    uint8_t* mapped = (uint8_t*)mmap(NULL, mapped_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        fprintf(stderr, "%s\n", "Could not map temporary audio file");
+        close(fd);
+        return 0;
+    }
+
+    if (stream->nb_samples > 0) {
+        memcpy(mapped, stream->stream, stream->nb_samples * stream->nb_channels);
+    }
+    audio_stream_release_buffer(stream);
+    stream->stream = mapped;
+    stream->backing_fd = fd;
+    stream->mapped_bytes = mapped_bytes;
+    if (stream->sample_capacity == 0) {
+        stream->sample_capacity = 1;
+    }
+    return 1;
+}
+
+void audio_stream_adopt(AudioStream* stream, AudioStream* source) {
+    const size_t position = audio_stream_start_sample(stream) + stream->playhead;
+    audio_stream_release_buffer(stream);
+    tracked_mutex_lock(&stream->envelope_lock);
+    if (stream->envelope != NULL) {
+        waveform_envelope_free(stream->envelope);
+    }
+    stream->envelope = source->envelope;
+    tracked_mutex_unlock(&stream->envelope_lock);
+
+    stream->stream = source->stream;
+    stream->backing_fd = source->backing_fd;
+    stream->mapped_bytes = source->mapped_bytes;
+    stream->start_time = source->start_time;
+    stream->nb_samples = source->nb_samples;
+    stream->sample_capacity = source->sample_capacity;
+    stream->nb_channels = source->nb_channels;
+    stream->sample_rate = source->sample_rate;
+    stream->complete = 1;
+    stream->trimmed_samples = 0;
+
+    const size_t start_sample = audio_stream_start_sample(stream);
+    stream->playhead = position > start_sample ? position - start_sample : 0;
+    stream->playhead = stream->playhead < stream->nb_samples ? stream->playhead : stream->nb_samples;
+
+    source->stream = NULL;
+    source->backing_fd = -1;
+    source->mapped_bytes = 0;
+    source->envelope = NULL;
+    source->nb_samples = 0;
+    source->sample_capacity = 0;
+}
+
 void audio_stream_free(AudioStream* stream) {
-    if (stream->stream != NULL) {
-        free(stream->stream);
+    audio_stream_release_buffer(stream);
+    if (stream->envelope != NULL) {
+        waveform_envelope_free(stream->envelope);
     }
+    tracked_mutex_destroy(&stream->envelope_lock);
+    tracked_mutex_destroy(&stream->lock);
     free(stream);
 }
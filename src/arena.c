@@ -0,0 +1,120 @@
+#include <arena.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+_Thread_local FrameArena* bound_frame_arena = NULL;
+
+FrameArena* frame_arena_alloc(size_t capacity) {
+    FrameArena* arena = (FrameArena*)malloc(sizeof(FrameArena));
+    if (arena == NULL) {
+        fprintf(stderr, "%s\n", "Could not allocate frame arena");
+        return NULL;
+    }
+
+    arena->data = (unsigned char*)malloc(capacity);
+    if (arena->data == NULL) {
+        fprintf(stderr, "%s\n", "Could not allocate frame arena buffer");
+        free(arena);
+        return NULL;
+    }
+
+    arena->capacity = capacity;
+    arena->used = 0;
+    arena->overflow = NULL;
+    arena->overflow_bytes = 0;
+    arena->frame = (FrameArenaStats){ 0, 0, 0 };
+    arena->last_frame = (FrameArenaStats){ 0, 0, 0 };
+    arena->nb_frames = 0;
+    return arena;
+}
+
+void frame_arena_free_overflow(FrameArena* arena) {
+    FrameArenaBlock* block = arena->overflow;
+    while (block != NULL) {
+        FrameArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->overflow = NULL;
+    arena->overflow_bytes = 0;
+}
+
+void frame_arena_free(FrameArena* arena) {
+    if (bound_frame_arena == arena) {
+        bound_frame_arena = NULL;
+    }
+    frame_arena_free_overflow(arena);
+    free(arena->data);
+    free(arena);
+}
+
+void* frame_arena_push(FrameArena* arena, size_t size) {
+    const size_t aligned = (size + FRAME_ARENA_ALIGNMENT - 1) & ~(size_t)(FRAME_ARENA_ALIGNMENT - 1);
+    arena->frame.bytes += aligned;
+    arena->frame.allocs++;
+
+    if (arena->used + aligned <= arena->capacity) {
+        void* ptr = arena->data + arena->used;
+        arena->used += aligned;
+        return ptr;
+    }
+
+    FrameArenaBlock* block = (FrameArenaBlock*)malloc(FRAME_ARENA_ALIGNMENT + aligned);
+    if (block == NULL) {
+        fprintf(stderr, "%s %zu %s\n", "Could not allocate", aligned, "byte frame arena overflow block");
+        return NULL;
+    }
+
+    block->next = arena->overflow;
+    block->size = aligned;
+    arena->overflow = block;
+    arena->overflow_bytes += aligned;
+    arena->frame.system_allocs++;
+    return (unsigned char*)block + FRAME_ARENA_ALIGNMENT;
+}
+
+void frame_arena_reset(FrameArena* arena) {
+    if (arena->overflow != NULL) {
+        size_t capacity = arena->capacity * 2;
+        while (capacity < arena->used + arena->overflow_bytes) {
+            capacity *= 2;
+        }
+
+        frame_arena_free_overflow(arena);
+        unsigned char* data = (unsigned char*)malloc(capacity);
+        if (data != NULL) {
+            free(arena->data);
+            arena->data = data;
+            arena->capacity = capacity;
+            arena->frame.system_allocs++;
+        }
+    }
+
+    // frames that never touch the arena (e.g. the debug view) keep the last real frame's stats visible
+    if (arena->frame.allocs > 0) {
+        arena->last_frame = arena->frame;
+    }
+    arena->frame = (FrameArenaStats){ 0, 0, 0 };
+    arena->used = 0;
+    arena->nb_frames++;
+}
+
+FrameArena* frame_arena_bind(FrameArena* arena) {
+    FrameArena* previous = bound_frame_arena;
+    bound_frame_arena = arena;
+    return previous;
+}
+
+void* frame_arena_malloc(size_t size, FrameArena** owner) {
+    *owner = bound_frame_arena;
+    if (bound_frame_arena != NULL) {
+        return frame_arena_push(bound_frame_arena, size);
+    }
+    return malloc(size);
+}
+
+void frame_arena_release(void* ptr, FrameArena* owner) {
+    if (owner == NULL) {
+        free(ptr);
+    }
+}
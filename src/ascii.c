@@ -1,14 +1,106 @@
 #include <pixeldata.h>
 #include <image.h>
 #include <ascii.h>
+#include <integral.h>
 #include <macros.h>
 #include <stdint.h>
 #include <wmath.h>
 #include <ncurses.h>
+#include <pthread.h>
+#include <string.h>
 #include <libavutil/avutil.h>
 
-const int nb_val_chars = 11;
-const char val_chars[11] = "@\%#*+=-:._ ";
+const char* glyph_ramp_names[NB_GLYPH_RAMPS] = { "standard", "detailed", "blocks", "shades" };
+const char* glyph_ramp_sources[NB_GLYPH_RAMPS] = {
+    "@%#*+=-:._ ",
+    "@MBHENR#KWXDFPQASUZbdehx*8Gm&04LOVYkpq5Tagns69owz$CIu23Jcfry%1v7l+it[]{}?j|()=~!-/<>\"^_';,:`. ",
+    "█▉▊▋▌▍▎▏ ",
+    "█▓▒░ "
+};
+
+GlyphRamp glyph_ramps[NB_GLYPH_RAMPS];
+const GlyphRamp* active_glyph_ramp = &glyph_ramps[0];
+pthread_once_t glyph_ramps_built = PTHREAD_ONCE_INIT;
+uint8_t identity_value_lut[256];
+
+void build_glyph_ramp(GlyphRamp* ramp, const char* name, const char* source) {
+    ramp->name = name;
+    ramp->nb_glyphs = 0;
+    ramp->single_byte = 1;
+    ramp->blank = 0;
+
+    const unsigned char* current = (const unsigned char*)source;
+    while (*current != '\0' && ramp->nb_glyphs < GLYPH_RAMP_MAX_GLYPHS) {
+        int length = 1;
+        if (*current >= 0xF0) {
+            length = 4;
+        } else if (*current >= 0xE0) {
+            length = 3;
+        } else if (*current >= 0xC0) {
+            length = 2;
+        }
+
+        memcpy(ramp->glyphs[ramp->nb_glyphs], current, length);
+        ramp->glyphs[ramp->nb_glyphs][length] = '\0';
+        ramp->single_byte &= length == 1;
+        if (length == 1 && *current == ' ') {
+            ramp->blank = ramp->nb_glyphs;
+        }
+        ramp->nb_glyphs++;
+        current += length;
+    }
+
+    for (int value = 0; value < 256; value++) {
+        ramp->value_to_glyph[value] = value * ramp->nb_glyphs / 256;
+    }
+
+    for (int glyph = 0; glyph < ramp->nb_glyphs; glyph++) {
+        ramp->glyph_to_value[glyph] = ramp->nb_glyphs > 1 ? glyph * 255 / (ramp->nb_glyphs - 1) : 0;
+    }
+}
+
+void build_glyph_ramps() {
+    for (int value = 0; value < 256; value++) {
+        identity_value_lut[value] = value;
+    }
+
+    for (int i = 0; i < NB_GLYPH_RAMPS; i++) {
+        build_glyph_ramp(&glyph_ramps[i], glyph_ramp_names[i], glyph_ramp_sources[i]);
+    }
+}
+
+void init_glyph_ramps() {
+    pthread_once(&glyph_ramps_built, build_glyph_ramps);
+}
+
+const GlyphRamp* get_glyph_ramp(const char* name) {
+    init_glyph_ramps();
+    for (int i = 0; i < NB_GLYPH_RAMPS; i++) {
+        if (strcmp(glyph_ramps[i].name, name) == 0) {
+            return &glyph_ramps[i];
+        }
+    }
+    return NULL;
+}
+
+const GlyphRamp* get_active_glyph_ramp() {
+    init_glyph_ramps();
+    return active_glyph_ramp;
+}
+
+int set_active_glyph_ramp(const char* name) {
+    const GlyphRamp* ramp = get_glyph_ramp(name);
+    if (ramp == NULL) {
+        fprintf(stderr, "%s %s\n", "Unknown glyph ramp", name);
+        return 0;
+    }
+    active_glyph_ramp = ramp;
+    return 1;
+}
+
+const char* get_glyph_ramp_name(int index) {
+    return index >= 0 && index < NB_GLYPH_RAMPS ? glyph_ramp_names[index] : NULL;
+}
 
 AsciiImage* get_ascii_image_from_frame(AVFrame* videoFrame, int maxWidth, int maxHeight) {
     PixelData* data = pixel_data_alloc_from_frame(videoFrame);
@@ -25,45 +117,45 @@ AsciiImage* get_ascii_image_bounded(PixelData* pixelData, int maxWidth, int maxH
 
 
 AsciiImage* ascii_image_alloc(int width, int height, int colored) {
-    AsciiImage* dst = (AsciiImage*)malloc(sizeof(AsciiImage));
+    FrameArena* arena;
+    AsciiImage* dst = (AsciiImage*)frame_arena_malloc(sizeof(AsciiImage), &arena);
+    if (dst == NULL) {
+        return NULL;
+    }
+
     dst->width = width;
     dst->height = height;
     dst->colored = colored;
-    dst->lines = colored ? (char*)malloc(sizeof(char) * width * height * 3) : (char*)malloc(sizeof(char) * width * height);
-    if (dst->lines == NULL) {
-        free(dst);
+    dst->arena = arena;
+    dst->ramp = get_active_glyph_ramp();
+    dst->glyphs = (uint8_t*)frame_arena_malloc(sizeof(uint8_t) * width * height, &arena);
+    if (dst->glyphs == NULL) {
+        frame_arena_release(dst, arena);
         return NULL;
     }
 
     if (colored) {
-        dst->color_data = (rgb*)malloc(sizeof(rgb) * width * height);
+        dst->color_data = (rgb*)frame_arena_malloc(sizeof(rgb) * width * height, &arena);
         if (dst->color_data == NULL) {
-            free(dst->lines);
-            free(dst);
+            frame_arena_release(dst->glyphs, arena);
+            frame_arena_release(dst, arena);
             return NULL;
         }
+        memset(dst->color_data, 0, sizeof(rgb) * width * height);
     } else {
         dst->color_data = NULL;
     }
 
-  for (int i = 0; i < height; i++) {
-      for (int j = 0; j < width; j++) {
-          dst->lines[i * width + j] = ' ';
-          if (colored) {
-              rgb_set(dst->color_data[i * width + j], 0, 0, 0);
-          }
-      }
-  }
-
+    memset(dst->glyphs, dst->ramp->blank, sizeof(uint8_t) * width * height);
     return dst;
 }
 
 void ascii_image_free(AsciiImage* image) {
-    free(image->lines);
+    frame_arena_release(image->glyphs, image->arena);
     if (image->color_data != NULL) {
-        free(image->color_data);
+        frame_arena_release(image->color_data, image->arena);
     }
-    free(image);
+    frame_arena_release(image, image->arena);
 }
 
 AsciiImage* copy_ascii_image(AsciiImage* src) {
@@ -72,93 +164,165 @@ AsciiImage* copy_ascii_image(AsciiImage* src) {
         return NULL;
     }
     
-    for (int row = 0; row < src->width; row++) {
-        for (int col = 0; col < src->height; col++) {
-            dst->lines[row * dst->width + col] = src->lines[row * src->width + col];
-            rgb_copy(dst->color_data[row * dst->width + col], src->color_data[row * src->width + col]);
-        }
+    dst->ramp = src->ramp;
+    memcpy(dst->glyphs, src->glyphs, sizeof(uint8_t) * src->width * src->height);
+    if (src->colored) {
+        memcpy(dst->color_data, src->color_data, sizeof(rgb) * src->width * src->height);
     }
 
     return dst;
 }
 
-AsciiImage* get_ascii_image(uint8_t* pixels, int srcWidth, int srcHeight, int outputWidth, int outputHeight, PixelDataFormat pixel_format) {
+const char* ascii_image_glyph(AsciiImage* image, int index) {
+    const uint8_t glyph = image->glyphs[index];
+    return glyph < image->ramp->nb_glyphs ? image->ramp->glyphs[glyph] : " ";
+}
+
+void fill_ascii_image_from_integral(AsciiImage* textImage, IntegralImage* integral, const uint8_t* value_lut, uint32_t* histogram) {
+    for (int row = 0; row < textImage->height; row++) {
+        int y0, y1;
+        integral_image_cell_span(row, textImage->height, integral->height, &y0, &y1);
+
+        for (int col = 0; col < textImage->width; col++) {
+            int x0, x1;
+            integral_image_cell_span(col, textImage->width, integral->width, &x0, &x1);
+
+            const uint8_t value = integral_image_avg_luma(integral, x0, y0, x1, y1);
+            if (textImage->colored) {
+                integral_image_avg_rgb(integral, x0, y0, x1, y1, textImage->color_data[row * textImage->width + col]);
+            }
+
+            textImage->glyphs[row * textImage->width + col] = value_lut[value];
+            if (histogram != NULL) {
+                histogram[value]++;
+            }
+        }
+    }
+}
+
+AsciiImage* build_ascii_image(uint8_t* pixels, int srcWidth, int srcHeight, int outputWidth, int outputHeight, PixelDataFormat pixel_format, const uint8_t* value_lut, uint32_t* histogram) {
   AsciiImage* textImage = ascii_image_alloc(outputWidth, outputHeight, pixel_format == RGB24 ? true : false);
   if (textImage == NULL) {
       return NULL;
   }
 
+  if (value_lut == NULL) {
+      value_lut = textImage->ramp->value_to_glyph;
+  }
+
   if (srcWidth <= outputWidth && srcHeight <= outputHeight) {
       for (int row = 0; row < outputHeight; row++) {
           for (int col = 0; col < outputWidth; col++) {
-
+              uint8_t value = 0;
               if (pixel_format == GRAYSCALE8) {
-                int pixel = row * srcWidth + col;
-                textImage->lines[row * outputWidth + col] = get_char_from_value(pixels[pixel]);
+                  value = pixels[row * srcWidth + col];
               } else if (pixel_format == RGB24) {
                   int start_pixel = row * srcWidth * 3 + col * 3;
                   rgb values;
                   rgb_set(values, pixels[start_pixel], pixels[start_pixel + 1], pixels[start_pixel + 2]);
-                  textImage->lines[row * outputWidth + col] = get_char_from_rgb(values);
+                  value = get_grayscale_rgb(values);
                   rgb_copy(textImage->color_data[row * outputWidth + col], values);
               }
 
+              textImage->glyphs[row * outputWidth + col] = value_lut[value];
+              if (histogram != NULL) {
+                  histogram[value]++;
+              }
           }
-          /* textImage->lines[rooutputWidth] = '\0'; */
       }
   } else {
-    double scanWidth = (double)srcWidth / outputWidth;
-    double scanHeight = (double)srcHeight / outputHeight;
-    double currentRowPixel = 0;
-    double currentColPixel = 0;
-
-    for (int row = 0; row < outputHeight; row++) {
-      currentColPixel = 0;
-      int checkWidth, checkHeight;
-      checkHeight = currentRowPixel != 0 ? (int)round(currentRowPixel - scanHeight * (row - 1)) : (int)scanHeight;
-
-      for (int col = 0; col < outputWidth; col++) {
-        checkWidth = currentColPixel != 0 ? (int)round(currentColPixel - scanWidth * (col - 1)) : (int)scanWidth;
-
-        if (pixel_format == GRAYSCALE8) {
-            textImage->lines[row * outputWidth + col] = get_char_from_area(pixels, (int)currentColPixel, (int)currentRowPixel, checkWidth, checkHeight, srcWidth, srcHeight);
-        } else if (pixel_format == RGB24) {
-            textImage->lines[row * outputWidth + col] = get_char_from_area_rgb(pixels, (int)currentColPixel, (int)currentRowPixel, checkWidth, checkHeight, srcWidth, srcHeight);
-            get_avg_color_from_area_rgb(pixels, (int)currentColPixel, (int)currentRowPixel, checkWidth, checkHeight, srcWidth, srcHeight, textImage->color_data[row * outputWidth + col]);
-        }
-
-        currentColPixel += scanWidth;
+      IntegralImage* integral = integral_image_alloc(pixels, srcWidth, srcHeight, pixel_format);
+      if (integral == NULL) {
+          ascii_image_free(textImage);
+          return NULL;
       }
-
-      /* textImage.lines[row][outputWidth] = '\0'; */
-      currentRowPixel += scanHeight;
-    }
+      fill_ascii_image_from_integral(textImage, integral, value_lut, histogram);
+      integral_image_free(integral);
   }
 
   return textImage;
 }
 
+AsciiImage* get_ascii_image(uint8_t* pixels, int srcWidth, int srcHeight, int outputWidth, int outputHeight, PixelDataFormat pixel_format) {
+    return build_ascii_image(pixels, srcWidth, srcHeight, outputWidth, outputHeight, pixel_format, NULL, NULL);
+}
+
+AsciiImage* get_ascii_image_equalized(PixelData* pixelData, int maxWidth, int maxHeight, ContrastEqualizer* equalizer) {
+    int outputWidth, outputHeight;
+    get_output_size(pixelData->width, pixelData->height, maxWidth, maxHeight, &outputWidth, &outputHeight);
+
+    uint32_t histogram[LUMA_HISTOGRAM_BINS];
+    memset(histogram, 0, sizeof(histogram));
+    AsciiImage* textImage = build_ascii_image(pixelData->pixels, pixelData->width, pixelData->height, outputWidth, outputHeight, pixelData->format, identity_value_lut, histogram);
+    if (textImage == NULL) {
+        return NULL;
+    }
+
+    uint8_t glyph_lut[LUMA_HISTOGRAM_BINS];
+    contrast_equalizer_update(equalizer, histogram, textImage->width * textImage->height);
+    contrast_equalizer_compose(equalizer, textImage->ramp->value_to_glyph, glyph_lut);
+    for (int i = 0; i < textImage->width * textImage->height; i++) {
+        textImage->glyphs[i] = glyph_lut[textImage->glyphs[i]];
+    }
 
-char get_char_from_value(uint8_t value) {
-  return val_chars[ (int)value * (nb_val_chars - 1) / 255 ];
+    return textImage;
 }
 
-int get_rgb_from_char(rgb output, char ch) {
-    for (int i = 0; i < nb_val_chars; i++) {
-        if (ch == val_chars[i]) {
-            uint8_t val = i * 255 / (nb_val_chars - 1); 
-            rgb_set(output, val, val, val);
-            return 1;
+
+PixelData* get_pixel_data_reduced(PixelData* pixelData, int outputWidth, int outputHeight) {
+    if (pixelData->width <= outputWidth && pixelData->height <= outputHeight) {
+        return copy_pixel_data(pixelData);
+    }
+
+    PixelData* reduced = pixel_data_alloc(outputWidth, outputHeight, pixelData->format);
+    if (reduced == NULL) {
+        return NULL;
+    }
+
+    IntegralImage* integral = integral_image_alloc_from_pixel_data(pixelData);
+    if (integral == NULL) {
+        pixel_data_free(reduced);
+        return NULL;
+    }
+
+    for (int row = 0; row < outputHeight; row++) {
+        int y0, y1;
+        integral_image_cell_span(row, outputHeight, pixelData->height, &y0, &y1);
+
+        for (int col = 0; col < outputWidth; col++) {
+            int x0, x1;
+            integral_image_cell_span(col, outputWidth, pixelData->width, &x0, &x1);
+
+            if (pixelData->format == GRAYSCALE8) {
+                reduced->pixels[row * outputWidth + col] = integral_image_avg_luma(integral, x0, y0, x1, y1);
+            } else if (pixelData->format == RGB24) {
+                integral_image_avg_rgb(integral, x0, y0, x1, y1, reduced->pixels + (row * outputWidth + col) * 3);
+            }
         }
     }
-    return 0;
+    integral_image_free(integral);
+
+    return reduced;
+}
+
+uint8_t get_glyph_from_value(uint8_t value) {
+    return active_glyph_ramp->value_to_glyph[value];
+}
+
+void get_rgb_from_glyph(rgb output, const GlyphRamp* ramp, uint8_t glyph) {
+    const uint8_t value = glyph < ramp->nb_glyphs ? ramp->glyph_to_value[glyph] : 0;
+    rgb_set(output, value, value, value);
 }
 
-char get_char_from_rgb(rgb colors) {
-    return val_chars[get_grayscale_rgb(colors) * (nb_val_chars - 1) / 255];
+uint8_t get_glyph_from_rgb(rgb colors) {
+    return active_glyph_ramp->value_to_glyph[get_grayscale_rgb(colors)];
 }
 
-char get_char_from_area(uint8_t* pixels, int x, int y, int width, int height, int pixelWidth, int pixelHeight) {
+uint8_t get_glyph_from_area(uint8_t* pixels, int x, int y, int width, int height, int pixelWidth, int pixelHeight) {
+    return active_glyph_ramp->value_to_glyph[get_avg_value_from_area(pixels, x, y, width, height, pixelWidth, pixelHeight)];
+}
+
+uint8_t get_avg_value_from_area(uint8_t* pixels, int x, int y, int width, int height, int pixelWidth, int pixelHeight) {
   int value = 0;
   int valueCount = 0;
 
@@ -172,24 +336,28 @@ char get_char_from_area(uint8_t* pixels, int x, int y, int width, int height, in
     }
   }
 
-    return valueCount > 0 ? val_chars[ value * (nb_val_chars - 1) / (255 * valueCount) ] : val_chars[0];
+  return valueCount > 0 ? value / valueCount : 0;
 }
 
-char get_char_from_area_rgb(uint8_t* pixels, int x, int y, int width, int height, int pixelWidth, int pixelHeight ) {
+uint8_t get_avg_luma_from_area_rgb(uint8_t* pixels, int x, int y, int width, int height, int pixelWidth, int pixelHeight) {
   int value = 0;
   int valueCount = 0;
 
   for (int row = 0; row < height; row++) {
     for (int col = 0; col < width; col++) {
       int pixelIndex = (row + y) * 3 * pixelWidth + (x + col) * 3;
-      if (pixelIndex + 2 < pixelWidth * pixelHeight * 9 && pixelIndex >= 0 && (x + col) < pixelWidth && (row + y) < pixelHeight  ) {
+      if (pixelIndex + 2 < pixelWidth * pixelHeight * 3 && pixelIndex >= 0 && (x + col) < pixelWidth && (row + y) < pixelHeight  ) {
         value += get_grayscale(pixels[pixelIndex], pixels[pixelIndex + 1], pixels[pixelIndex + 2]);
         valueCount++;
       }
     }
   }
 
-    return valueCount > 0 ? val_chars[ value * nb_val_chars / (255 * valueCount) ] : val_chars[0];
+  return valueCount > 0 ? value / valueCount : 0;
+}
+
+uint8_t get_glyph_from_area_rgb(uint8_t* pixels, int x, int y, int width, int height, int pixelWidth, int pixelHeight) {
+    return active_glyph_ramp->value_to_glyph[get_avg_luma_from_area_rgb(pixels, x, y, width, height, pixelWidth, pixelHeight)];
 }
 
 void get_avg_color_from_area_rgb(uint8_t* pixels, int x, int y, int width, int height, int pixelWidth, int pixelHeight, rgb output) {
@@ -241,8 +409,8 @@ void overlap_ascii_images(AsciiImage* first, AsciiImage* second) {
 
   for (int row = 0; row < second->height; row++) {
     for (int col = 0; col < second->width; col++) {
-      if (topLeftY + row < first->height && topLeftX + col < first->width && second->lines[row * second->width + col] != '\0') {
-        first->lines[(topLeftY + row) * first->width + topLeftX + col] = second->lines[row * second->width + col];
+      if (topLeftY + row < first->height && topLeftX + col < first->width && second->glyphs[row * second->width + col] != GLYPH_NONE) {
+        first->glyphs[(topLeftY + row) * first->width + topLeftX + col] = second->glyphs[row * second->width + col];
         if (first->colored && second->colored) {
             rgb_copy(first->color_data[(topLeftY + row) * first->width + topLeftX + col], second->color_data[row * second->width + col]);
         }
@@ -258,17 +426,20 @@ int ascii_init_color(AsciiImage* image) {
     }
 
     if (image->color_data != NULL) {
-        free(image->color_data);
+        frame_arena_release(image->color_data, image->arena);
     }
 
-    image->color_data = (rgb*)malloc(sizeof(rgb) * image->width * image->height);
+    FrameArena* arena = image->arena;
+    FrameArena* previous = frame_arena_bind(arena);
+    image->color_data = (rgb*)frame_arena_malloc(sizeof(rgb) * image->width * image->height, &arena);
+    frame_arena_bind(previous);
     if (image->color_data == NULL) {
         return 0;
     }
 
     rgb output;
     for (int i = 0; i < image->width * image->height; i++) {
-        get_rgb_from_char(output, image->lines[i]);
+        get_rgb_from_glyph(output, image->ramp, image->glyphs[i]);
         rgb_copy(image->color_data[i], output);
     }
     image->colored = true;
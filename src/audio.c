@@ -8,9 +8,15 @@
 #include <audio.h>
 #include <wmath.h>
 #include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
 #include <threads.h>
 #include <macros.h>
+#include <gain.h>
+#include <sampleconv.h>
+#include <predecode.h>
+#include <drift.h>
+#include <loader.h>
 
 #define MINIAUDIO_IMPLEMENTATION
 #include "miniaudio.h"
@@ -21,51 +27,87 @@
 #include <libswresample/swresample.h>
 #include <libavutil/audio_fifo.h>
 
-const int AUDIO_BUFFER_SIZE = 8192;
-const int MAX_AUDIO_BUFFER_SIZE = 524288;
-
 typedef struct CallbackData {
     MediaPlayer* player;
-    pthread_mutex_t* mutex;
     AudioResampler* audioResampler;
+    GainStage gain;
+    const SampleConversionKernels* kernels;
 } CallbackData;
 
 const char* debug_audio_source = "audio";
 const char* debug_audio_type = "debug";
 
-AVFrame** get_final_audio_frames(AVCodecContext* audioCodecContext, AudioResampler* audioResampler, AVPacket* packet, int* result, int* nb_frames_decoded);
-AVFrame** find_final_audio_frames(AVCodecContext* audioCodecContext, AudioResampler* audioResampler, SelectionList* packet_buffer, int* result, int* nb_frames_decoded);
+int decode_audio_packet_into_stream(AVCodecContext* audioCodecContext, SwrContext* resampler, AVPacket* packet, AVFrame* decodeFrame, AudioStream* audioStream);
+int audio_stream_write_frame(AudioStream* audioStream, SwrContext* resampler, AVFrame* frame);
+void update_spectrum(SpectrumAnalyzer* analyzer, AudioStream* audioStream);
 AVAudioFifo* av_audio_fifo_combine(AVAudioFifo* first, AVAudioFifo* second);
+float convert_callback_frames(CallbackData* data, float* dst, const uint8_t* src, int nb_frames, int nb_channels, double phase, double step, float gain);
 
 void audioDataCallback(ma_device* pDevice, void* pOutput, const void* pInput, ma_uint32 frameCount)
 {
     CallbackData* data = (CallbackData*)(pDevice->pUserData);
-    pthread_mutex_lock(data->mutex);
     AudioStream* audioStream = data->player->displayCache->audio_stream;
-
     if (audioStream == NULL) {
-        pthread_mutex_unlock(data->mutex);
         return;
     }
 
-    if (audioStream->playhead + frameCount < audioStream->nb_samples) {
-        for (int i = 0; i < frameCount * audioStream->nb_channels; i++) {
-            /* ((float*)(pOutput))[i] = audioStream->stream[audioStream->playhead * audioStream->nb_channels + i]; */
-            /* ((float*)(pOutput))[i] = ((int)((255.0 / 2) * (audioStream->stream[audioStream->playhead * audioStream->nb_channels + i] + 1)) - 128) / 128.0  ; */
-            ((float*)(pOutput))[i] = uint8_sample_to_float(audioStream->stream[audioStream->playhead * audioStream->nb_channels + i]);
+    tracked_mutex_lock(&audioStream->lock);
+
+    const int nb_channels = audioStream->nb_channels;
+    const double rate = audioStream->read_rate;
+    if (rate == 1.0) {
+        audioStream->read_phase = 0.0;
+    }
+    // drift correction reads slightly faster or slower than real time, interpolating one frame ahead
+    const double end = audioStream->read_phase + frameCount * rate;
+    const size_t consumed = (size_t)end;
+    const size_t nb_required = rate == 1.0 ? consumed : consumed + 1;
+
+    if (audioStream->playhead + nb_required < audioStream->nb_samples) {
+        const uint8_t* source = audioStream->stream + audioStream->playhead * nb_channels;
+        float* output = (float*)pOutput;
+        GainStage* gain = &data->gain;
+        gain_stage_set_target(gain, (float)data->player->timeline->playback->volume);
+
+        float peak = 0.0f;
+        int clipped = 0;
+        const int nb_ramped = i32min(gain->ramp_remaining, (int)frameCount);
+        if (nb_ramped > 0) {
+            convert_callback_frames(data, output, source, nb_ramped, nb_channels, audioStream->read_phase, rate, 1.0f);
+            gain_stage_ramp(gain, output, nb_ramped, nb_channels, &peak, &clipped);
+        }
+
+        if (nb_ramped < (int)frameCount) {
+            float* steady = output + nb_ramped * nb_channels;
+            const int nb_steady = frameCount - nb_ramped;
+            const float steady_peak = convert_callback_frames(data, steady, source, nb_steady, nb_channels, audioStream->read_phase + nb_ramped * rate, rate, gain->current);
+            if (steady_peak > 1.0f) {
+                int steady_clipped;
+                gain_block(steady, nb_steady * nb_channels, 1.0f, &steady_clipped);
+                clipped += steady_clipped;
+            }
+            peak = steady_peak > peak ? steady_peak : peak;
         }
 
-        audioStream->playhead += frameCount;
+        audio_meter_update(&data->player->displayCache->audio_meter, peak, clipped);
+        audioStream->playhead += consumed;
+        audioStream->read_phase = end - consumed;
     }
 
     (void)pInput;
-    pthread_mutex_unlock(data->mutex);
+    tracked_mutex_unlock(&audioStream->lock);
+}
+
+float convert_callback_frames(CallbackData* data, float* dst, const uint8_t* src, int nb_frames, int nb_channels, double phase, double step, float gain) {
+    if (step == 1.0) {
+        return data->kernels->u8_to_f32(dst, src + (size_t)phase * nb_channels, nb_frames * nb_channels, gain);
+    }
+    return data->kernels->u8_to_f32_resampled(dst, src, nb_frames, nb_channels, phase, step, gain);
 }
 
 void* audio_playback_thread(void* args) {
     MediaThreadData* thread_data = (MediaThreadData*)args;
     MediaPlayer* player = thread_data->player;
-    pthread_mutex_t* alterMutex = thread_data->alterMutex;
     MediaDebugInfo* debug_info = player->displayCache->debug_info;
     int result;
     MediaStream* audio_stream = get_media_stream(player->timeline->mediaData, AVMEDIA_TYPE_AUDIO);
@@ -78,14 +120,17 @@ void* audio_playback_thread(void* args) {
     const int nb_channels = audioCodecContext->ch_layout.nb_channels;
 
     AudioResampler* audioResampler = get_audio_resampler(&result,     
-            &(audioCodecContext->ch_layout), AV_SAMPLE_FMT_FLT, audioCodecContext->sample_rate,
+            &(audioCodecContext->ch_layout), AV_SAMPLE_FMT_U8, audioCodecContext->sample_rate,
             &(audioCodecContext->ch_layout), audioCodecContext->sample_fmt, audioCodecContext->sample_rate);
     if (audioResampler == NULL) {
         add_debug_message(player->displayCache->debug_info, debug_audio_source, debug_audio_type, "Audio Resampler Allocation Error", "COULD NOT ALLOCATE TEMPORARY AUDIO RESAMPLER");
         return NULL;
     }   
 
-    audio_stream_init(player->displayCache->audio_stream, nb_channels, AUDIO_BUFFER_SIZE, audioCodecContext->sample_rate);
+    AudioStream* audioStream = player->displayCache->audio_stream;
+    tracked_mutex_lock(&audioStream->lock);
+    audio_stream_init(audioStream, nb_channels, AUDIO_STREAM_WINDOW_SECONDS * audioCodecContext->sample_rate, audioCodecContext->sample_rate);
+    tracked_mutex_unlock(&audioStream->lock);
 
     ma_device_config config = ma_device_config_init(ma_device_type_playback);
     config.playback.format  = ma_format_f32;
@@ -93,7 +138,17 @@ void* audio_playback_thread(void* args) {
     config.sampleRate = audioCodecContext->sample_rate;           
     config.dataCallback = audioDataCallback;   
 
-    CallbackData userData = { player, alterMutex, audioResampler }; 
+    MediaAudioSettings* audioSettings = player->audioSettings;
+    config.periodSizeInFrames = audioSettings->period_size_frames;
+    config.periods = audioSettings->periods;
+    config.performanceProfile = audioSettings->profile == AUDIO_PROFILE_CONSERVATIVE ? ma_performance_profile_conservative : ma_performance_profile_low_latency;
+
+    CallbackData userData = {
+        .player = player,
+        .audioResampler = audioResampler,
+        .kernels = get_sample_conversion_kernels(),
+    };
+    gain_stage_init(&userData.gain, (float)player->timeline->playback->volume, audioCodecContext->sample_rate);
    config.pUserData = &userData;   
 
     ma_result miniAudioLog;
@@ -104,144 +159,258 @@ void* audio_playback_thread(void* args) {
         return NULL;  // Failed to initialize the device.
     }
 
+    const double deviceLatency = (double)audioDevice.playback.internalPeriodSizeInFrames * audioDevice.playback.internalPeriods / audioDevice.playback.internalSampleRate;
+    add_debug_message(debug_info, debug_audio_source, debug_audio_type, "Sample Conversion", "Sample conversion kernels: %s\n", userData.kernels->name);
+    add_debug_message(debug_info, debug_audio_source, debug_audio_type, "Audio Device Latency", "Audio Device: %u frames x %u periods at %u Hz (%s) = %.1f ms latency\n",
+            audioDevice.playback.internalPeriodSizeInFrames, audioDevice.playback.internalPeriods, audioDevice.playback.internalSampleRate,
+            audioSettings->profile == AUDIO_PROFILE_CONSERVATIVE ? "conservative" : "low latency", deviceLatency * SECONDS_TO_MILLISECONDS);
+
+    AudioPredecodeJob predecode = { player, 0, 0 };
+    if (should_predecode_audio(player)) {
+        start_audio_predecode(&predecode, player);
+    }
+
+    AVFrame* decodeFrame = av_frame_alloc();
+    SwrContext* resampler = audioCodecContext->sample_fmt == AV_SAMPLE_FMT_U8 ? NULL : audioResampler->context;
+    DriftController drift;
+    drift_controller_init(&drift);
+
     Playback* playback = player->timeline->playback;
+    PlayerState* state = player->state;
 
     sleep_for((long)(audio_stream->info->stream->start_time * audio_stream->timeBase * SECONDS_TO_NANOSECONDS));
     
     while (player->inUse) {
-        pthread_mutex_lock(alterMutex);
+        player_state_count_wakeup(state, PLAYER_THREAD_AUDIO);
 
         if (playback->playing == 0 && ma_device_get_state(&audioDevice) == ma_device_state_started) {
-            pthread_mutex_unlock(alterMutex);
             miniAudioLog = ma_device_stop(&audioDevice);
             if (miniAudioLog != MA_SUCCESS) {
                 fprintf(stderr, "%s %d\n", "Failed to stop playback: ", miniAudioLog);
                 ma_device_uninit(&audioDevice);
+                av_frame_free(&decodeFrame);
+                join_audio_predecode(&predecode);
                 return NULL;
             };
-            pthread_mutex_lock(alterMutex);
         } else if (playback->playing && ma_device_get_state(&audioDevice) == ma_device_state_stopped) {
-            pthread_mutex_unlock(alterMutex);
             miniAudioLog = ma_device_start(&audioDevice);
             if (miniAudioLog != MA_SUCCESS) {
                 fprintf(stderr, "%s %d\n", "Failed to start playback: ", miniAudioLog);
                 ma_device_uninit(&audioDevice);
+                av_frame_free(&decodeFrame);
+                join_audio_predecode(&predecode);
                 return NULL;
             };
-            pthread_mutex_lock(alterMutex);
         }
 
-        AudioStream* audioStream = player->displayCache->audio_stream;
-        if (selection_list_try_move_index(audio_stream->packets, 1)) {
-            AVPacket* packet = (AVPacket*)selection_list_get(audio_stream->packets);
-            int result, nb_frames_decoded;
-            AVFrame** audioFrames = get_final_audio_frames(audioCodecContext, audioResampler, packet, &result, &nb_frames_decoded);
-            if (audioFrames != NULL) {
-                if (result >= 0 && nb_frames_decoded > 0) {
-                    for (int i = 0; i < nb_frames_decoded; i++) {
-                        AVFrame* current_frame = audioFrames[i];
-
-                        if (current_frame->nb_samples + audioStream->nb_samples >= audioStream->sample_capacity) {
-                            uint8_t* tmp = (uint8_t*)realloc(audioStream->stream, sizeof(uint8_t) * audioStream->sample_capacity * audioStream->nb_channels * 2);
-
-                            if (tmp != NULL) {
-                                audioStream->stream = tmp;
-                                audioStream->sample_capacity *= 2;
-                            }
-                        }
-
-                        if (audioStream->nb_samples + current_frame->nb_samples < audioStream->sample_capacity) {
-                            float* frameData = (float*)(current_frame->data[0]);
-                            for (int i = 0; i < current_frame->nb_samples * current_frame->ch_layout.nb_channels; i++) {
-                                audioStream->stream[audioStream->nb_samples * audioStream->nb_channels + i] = float_sample_to_uint8(frameData[i]);
-                            }
-                            audioStream->nb_samples += current_frame->nb_samples;
-                        }
-                    }
-                }
-                free_frame_list(audioFrames, nb_frames_decoded);
+        if (playback->playing == 0) {
+            unsigned long seen_generation = player_state_generation(state);
+            while (playback->playing == 0 && player->inUse) {
+                player_state_wait_forever(state, seen_generation);
+                seen_generation = player_state_generation(state);
+                player_state_count_wakeup(state, PLAYER_THREAD_AUDIO);
             }
+            continue;
         }
 
+        tracked_mutex_lock(&audioStream->lock);
+        double buffered_seconds = audio_stream_buffered_seconds(audioStream);
+        const int complete = audioStream->complete;
+        tracked_mutex_unlock(&audioStream->lock);
+
+        int starved = 0;
+        if (!complete && buffered_seconds < AUDIO_LOOKAHEAD_SECONDS) {
+            int nb_batched = 0;
+            double batched_seconds = 0.0;
+
+            tracked_mutex_lock(&audio_stream->lock);
+            while (nb_batched < AUDIO_MAX_BATCH_PACKETS && buffered_seconds + batched_seconds < AUDIO_LOOKAHEAD_SECONDS) {
+                if (!selection_list_try_move_index(audio_stream->packets, 1)) {
+                    starved = 1;
+                    break;
+                }
+
+                AVPacket* packet = (AVPacket*)selection_list_get(audio_stream->packets);
+                const int nb_appended = decode_audio_packet_into_stream(audioCodecContext, resampler, packet, decodeFrame, audioStream);
+                if (nb_appended > 0) {
+                    batched_seconds += (double)nb_appended / audioCodecContext->sample_rate;
+                }
+                nb_batched++;
+            }
+            tracked_mutex_unlock(&audio_stream->lock);
+            wake_loader_if_starved(player->timeline->mediaData, audio_stream, state);
+
+            tracked_mutex_lock(&audioStream->lock);
+            buffered_seconds = audio_stream_buffered_seconds(audioStream);
+            tracked_mutex_unlock(&audioStream->lock);
+            add_debug_message(debug_info, debug_audio_source, debug_audio_type, "Audio Decode Batch", "Decoded %d packets (%.3f s), %.3f s buffered\n", nb_batched, batched_seconds, buffered_seconds);
+        }
 
         audioDevice.sampleRate = audioCodecContext->sample_rate * playback->speed;
         double current_time = get_playback_current_time(playback);
-        double desync = dabs(audio_stream_time(audioStream) - current_time);
-        add_debug_message(debug_info, debug_audio_source, debug_audio_type, "Audio Desync", "%s%.2f\n", "Audio Desync Amount: ", desync);
-        if (desync > 0.15) {
-            if (current_time > audio_stream_end_time(audioStream) || current_time < audioStream->start_time) {
-                int success = audio_stream_clear(audioStream, AUDIO_BUFFER_SIZE);
+        double target_time = current_time + deviceLatency * playback->speed;
+        int needs_seek = 0;
+
+        tracked_mutex_lock(&audioStream->lock);
+        const double measured_drift = audio_stream_time(audioStream) - target_time;
+        int hard_resync = 0;
+        if (dabs(measured_drift) > MAX_AUDIO_ASYNC_TIME_SECONDS) {
+            if (!audioStream->complete && (target_time > audio_stream_end_time(audioStream) || target_time < audio_stream_buffered_start_time(audioStream))) {
+                int success = audio_stream_clear(audioStream);
                 if (success) {
-                    audioStream->start_time = current_time;
-                    move_packet_list_to_pts(audio_stream->packets, current_time / audio_stream->timeBase);
+                    audioStream->start_time = target_time;
+                    needs_seek = 1;
                 }
             } else {
-                audio_stream_set_time(audioStream, current_time);
+                audio_stream_set_time(audioStream, target_time);
             }
+            hard_resync = 1;
         }
+        if (hard_resync) {
+            audioStream->read_rate = 1.0;
+            audioStream->read_phase = 0.0;
+        }
+        buffered_seconds = audio_stream_buffered_seconds(audioStream);
+        tracked_mutex_unlock(&audioStream->lock);
+
+        const double now = clock_sec();
+        int sample_delta, compensation_distance;
+        if (hard_resync) {
+            drift.nb_hard_resyncs++;
+            drift_controller_reset(&drift);
+        } else {
+            if (drift_controller_update(&drift, measured_drift, now)) {
+                char drift_plot[AUDIO_DRIFT_PLOT_BUFFER_SIZE];
+                drift_controller_format(&drift, drift_plot, AUDIO_DRIFT_PLOT_BUFFER_SIZE);
+                add_debug_message(debug_info, debug_audio_source, debug_audio_type, "Audio Drift", "%s", drift_plot);
+            }
 
-        pthread_mutex_unlock(alterMutex);
-        sleep_for_ms(3);
-    }
+            if (drift_controller_compensation(&drift, audioCodecContext->sample_rate, now, &sample_delta, &compensation_distance)) {
+                tracked_mutex_lock(&audioStream->lock);
+                audioStream->read_rate = compensation_distance > 0 ? 1.0 - (double)sample_delta / compensation_distance : 1.0;
+                tracked_mutex_unlock(&audioStream->lock);
+            }
+        }
 
+        if (needs_seek) {
+            tracked_mutex_lock(&audio_stream->lock);
+            move_packet_list_to_pts(audio_stream->packets, target_time / audio_stream->timeBase);
+            tracked_mutex_unlock(&audio_stream->lock);
+        }
 
+        double wait_seconds = AUDIO_THREAD_WAIT_MILLISECONDS / (double)SECONDS_TO_MILLISECONDS;
+        if (starved) {
+            wait_seconds = AUDIO_STARVED_WAIT_MILLISECONDS / (double)SECONDS_TO_MILLISECONDS;
+        } else if (buffered_seconds > AUDIO_LOW_WATERMARK_SECONDS) {
+            wait_seconds = fmax(wait_seconds, fmin(AUDIO_LOOKAHEAD_SECONDS, buffered_seconds - AUDIO_LOW_WATERMARK_SECONDS) / playback->speed);
+        }
+
+        SpectrumAnalyzer* spectrum = player->displayCache->spectrum;
+        if (spectrum->enabled) {
+            update_spectrum(spectrum, audioStream);
+            wait_seconds = fmin(wait_seconds, (double)SPECTRUM_HOP_SIZE / audioCodecContext->sample_rate / playback->speed);
+        }
+
+        unsigned long seen_generation = player_state_generation(state);
+        player_state_wait(state, seen_generation, wait_seconds);
+    }
+
+    ma_device_uninit(&audioDevice);
+    av_frame_free(&decodeFrame);
+    join_audio_predecode(&predecode);
     free_audio_resampler(audioResampler);
     return NULL;
 }
 
-AVFrame** get_final_audio_frames(AVCodecContext* audioCodecContext, AudioResampler* audioResampler, AVPacket* packet, int* result, int* nb_frames_decoded) {
-    AVFrame** rawAudioFrames = decode_audio_packet(audioCodecContext, packet, result, nb_frames_decoded);
-    if (rawAudioFrames == NULL || *result < 0 || *nb_frames_decoded == 0) {
-        if (rawAudioFrames != NULL) {
-            free_frame_list(rawAudioFrames, *nb_frames_decoded);
-        }
+int decode_audio_packet_into_stream(AVCodecContext* audioCodecContext, SwrContext* resampler, AVPacket* packet, AVFrame* decodeFrame, AudioStream* audioStream) {
+    int result = avcodec_send_packet(audioCodecContext, packet);
+    if (result < 0 && result != AVERROR(EAGAIN)) {
+        return result;
+    }
 
-        return NULL;
+    int nb_appended = 0;
+    while (avcodec_receive_frame(audioCodecContext, decodeFrame) == 0) {
+        nb_appended += audio_stream_write_frame(audioStream, resampler, decodeFrame);
+        av_frame_unref(decodeFrame);
     }
 
-    AVFrame** audioFrames = resample_audio_frames(audioResampler, rawAudioFrames, *nb_frames_decoded);
-    free_frame_list(rawAudioFrames, *nb_frames_decoded);
-    return audioFrames;
+    return nb_appended;
 }
 
-AVFrame** find_final_audio_frames(AVCodecContext* audioCodecContext, AudioResampler* audioResampler, SelectionList* audioPackets, int* result, int* nb_frames_decoded) {
-    *result = 0;
-    AVPacket* currentPacket = (AVPacket*)selection_list_get(audioPackets);
-    while (currentPacket == NULL && selection_list_can_move_index(audioPackets, 1)) {
-        selection_list_try_move_index(audioPackets, 1);
-        currentPacket = (AVPacket*)selection_list_get(audioPackets);
+int audio_stream_write_frame(AudioStream* audioStream, SwrContext* resampler, AVFrame* frame) {
+    tracked_mutex_lock(&audioStream->lock);
+    const int max_output_samples = resampler != NULL ? swr_get_out_samples(resampler, frame->nb_samples) : frame->nb_samples;
+    if (audioStream->complete || max_output_samples <= 0) {
+        tracked_mutex_unlock(&audioStream->lock);
+        return 0;
     }
-    if (currentPacket == NULL) {
-        return NULL;
+
+    if (audioStream->sample_capacity - audioStream->nb_samples < (size_t)max_output_samples) {
+        audio_stream_trim(audioStream, (size_t)(AUDIO_STREAM_HISTORY_SECONDS * audioStream->sample_rate));
     }
 
+    if (!audio_stream_reserve(audioStream, audioStream->nb_samples + max_output_samples)) {
+        tracked_mutex_unlock(&audioStream->lock);
+        return 0;
+    }
 
-    AVFrame** audioFrames = get_final_audio_frames(audioCodecContext, audioResampler, currentPacket, result, nb_frames_decoded);
-    while (*result == AVERROR(EAGAIN) && selection_list_can_move_index(audioPackets, 1)) {
-        selection_list_try_move_index(audioPackets, 1);
-        if (audioFrames != NULL) {
-            free_frame_list(audioFrames, *nb_frames_decoded);
-        }
+    uint8_t* writeRegion = audioStream->stream + audioStream->nb_samples * audioStream->nb_channels;
+    const int writeCapacity = audioStream->sample_capacity - audioStream->nb_samples;
+    const size_t position = audio_stream_start_sample(audioStream) + audioStream->nb_samples;
+    tracked_mutex_unlock(&audioStream->lock);
 
-        currentPacket = (AVPacket*)selection_list_get(audioPackets);
-        while (currentPacket == NULL && selection_list_can_move_index(audioPackets, 1)) {
-            selection_list_try_move_index(audioPackets, 1);
-            currentPacket = (AVPacket*)selection_list_get(audioPackets);
-        }
-        if (currentPacket == NULL) {
-            return NULL;
+    int nb_written = frame->nb_samples;
+    if (resampler == NULL) {
+        memcpy(writeRegion, frame->data[0], frame->nb_samples * audioStream->nb_channels);
+    } else {
+        nb_written = swr_convert(resampler, &writeRegion, writeCapacity, (const uint8_t**)frame->extended_data, frame->nb_samples);
+        if (nb_written < 0) {
+            return 0;
         }
-        audioFrames = get_final_audio_frames(audioCodecContext, audioResampler, currentPacket, result, nb_frames_decoded);
     }
 
-    if (*result < 0 || *nb_frames_decoded == 0) {
-        if (audioFrames != NULL) {
-            free_frame_list(audioFrames, *nb_frames_decoded);
+    tracked_mutex_lock(&audioStream->envelope_lock);
+    if (audioStream->envelope != NULL) {
+        waveform_envelope_append(audioStream->envelope, position, writeRegion, nb_written);
+    }
+    tracked_mutex_unlock(&audioStream->envelope_lock);
+
+    tracked_mutex_lock(&audioStream->lock);
+    audioStream->nb_samples += nb_written;
+    tracked_mutex_unlock(&audioStream->lock);
+    return nb_written;
+}
+
+void update_spectrum(SpectrumAnalyzer* analyzer, AudioStream* audioStream) {
+    tracked_mutex_lock(&audioStream->lock);
+    const size_t position = audio_stream_start_sample(audioStream) + audioStream->playhead;
+    const int hop_due = position >= analyzer->last_position + SPECTRUM_HOP_SIZE || position < analyzer->last_position;
+    if (!hop_due || audioStream->stream == NULL || audioStream->playhead < SPECTRUM_FFT_SIZE || audioStream->playhead > audioStream->nb_samples) {
+        tracked_mutex_unlock(&audioStream->lock);
+        return;
+    }
+
+    if (analyzer->sample_rate != audioStream->sample_rate) {
+        spectrum_analyzer_configure(analyzer, audioStream->sample_rate);
+    }
+
+    const int nb_channels = audioStream->nb_channels;
+    const uint8_t* window_start = audioStream->stream + (audioStream->playhead - SPECTRUM_FFT_SIZE) * nb_channels;
+    for (int i = 0; i < SPECTRUM_FFT_SIZE; i++) {
+        float mixed = 0.0f;
+        for (int ch = 0; ch < nb_channels; ch++) {
+            mixed += uint8_sample_to_float(window_start[i * nb_channels + ch]);
         }
-        return NULL;
+        analyzer->input[i] = mixed / nb_channels;
     }
+    analyzer->last_position = position;
+    tracked_mutex_unlock(&audioStream->lock);
+
+    spectrum_analyzer_process(analyzer);
 
-    return audioFrames;
+    tracked_mutex_lock(&audioStream->lock);
+    spectrum_analyzer_publish(analyzer);
+    tracked_mutex_unlock(&audioStream->lock);
 }
 
 float** copy_samples(float** src, int linesize[8], int nb_channels, int nb_samples) {
@@ -0,0 +1,201 @@
+#include <benchmark.h>
+#include <sampleconv.h>
+#include <audio.h>
+#include <graphics.h>
+#include <pixeldata.h>
+#include <wtime.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+volatile float benchmark_sink;
+
+void print_benchmark_result(const char* label, double seconds, long nb_samples) {
+    printf("  %-32s %8.3f ns/sample %10.1f Msamples/s\n", label, seconds / nb_samples * 1e9, nb_samples / seconds / 1e6);
+}
+
+int run_benchmarks() {
+    benchmark_sample_conversion();
+    benchmark_graphics_encoders();
+    return EXIT_SUCCESS;
+}
+
+void benchmark_u8_scalar(float* dst, const uint8_t* src, int nb_samples) {
+    for (int i = 0; i < nb_samples; i++) {
+        dst[i] = uint8_sample_to_float(src[i]);
+    }
+}
+
+void benchmark_sample_conversion() {
+    const int nb_samples = BENCHMARK_AUDIO_FRAMES * BENCHMARK_AUDIO_CHANNELS;
+    const long total_samples = (long)nb_samples * BENCHMARK_AUDIO_ITERATIONS;
+    uint8_t* u8_samples = (uint8_t*)malloc(sizeof(uint8_t) * nb_samples);
+    int16_t* s16_samples = (int16_t*)malloc(sizeof(int16_t) * nb_samples);
+    float* f32_samples = (float*)malloc(sizeof(float) * nb_samples);
+    float* output = (float*)malloc(sizeof(float) * nb_samples);
+    float* planes[BENCHMARK_AUDIO_CHANNELS];
+    int planes_allocated = 1;
+    for (int ch = 0; ch < BENCHMARK_AUDIO_CHANNELS; ch++) {
+        planes[ch] = (float*)malloc(sizeof(float) * BENCHMARK_AUDIO_FRAMES);
+        planes_allocated &= planes[ch] != NULL;
+    }
+
+    if (u8_samples == NULL || s16_samples == NULL || f32_samples == NULL || output == NULL || !planes_allocated) {
+        fprintf(stderr, "%s\n", "Could not allocate sample conversion benchmark buffers");
+        free(u8_samples);
+        free(s16_samples);
+        free(f32_samples);
+        free(output);
+        for (int ch = 0; ch < BENCHMARK_AUDIO_CHANNELS; ch++) {
+            free(planes[ch]);
+        }
+        return;
+    }
+
+    for (int i = 0; i < nb_samples; i++) {
+        u8_samples[i] = rand() % 256;
+        s16_samples[i] = rand() % 65536 - 32768;
+        f32_samples[i] = (float)rand() / RAND_MAX * 2.0f - 1.0f;
+    }
+
+    const SampleConversionKernels* kernels[2] = { get_generic_sample_conversion_kernels(), get_sample_conversion_kernels() };
+    const int nb_kernels = kernels[0] == kernels[1] ? 1 : 2;
+    printf("Sample conversion: %d frames x %d channels, %d iterations, dispatched kernels: %s\n",
+            BENCHMARK_AUDIO_FRAMES, BENCHMARK_AUDIO_CHANNELS, BENCHMARK_AUDIO_ITERATIONS, kernels[1]->name);
+
+    double start = clock_sec();
+    for (int iteration = 0; iteration < BENCHMARK_AUDIO_ITERATIONS; iteration++) {
+        benchmark_u8_scalar(output, u8_samples, nb_samples);
+        benchmark_sink += output[iteration % nb_samples];
+    }
+    print_benchmark_result("u8 -> f32 (scalar)", clock_sec() - start, total_samples);
+
+    for (int k = 0; k < nb_kernels; k++) {
+        char label[64];
+        snprintf(label, sizeof(label), "u8 -> f32 (%s)", kernels[k]->name);
+        start = clock_sec();
+        for (int iteration = 0; iteration < BENCHMARK_AUDIO_ITERATIONS; iteration++) {
+            kernels[k]->u8_to_f32(output, u8_samples, nb_samples, 0.8f);
+            benchmark_sink += output[iteration % nb_samples];
+        }
+        print_benchmark_result(label, clock_sec() - start, total_samples);
+
+        snprintf(label, sizeof(label), "s16 -> f32 (%s)", kernels[k]->name);
+        start = clock_sec();
+        for (int iteration = 0; iteration < BENCHMARK_AUDIO_ITERATIONS; iteration++) {
+            kernels[k]->s16_to_f32(output, s16_samples, nb_samples, 0.8f);
+            benchmark_sink += output[iteration % nb_samples];
+        }
+        print_benchmark_result(label, clock_sec() - start, total_samples);
+
+        snprintf(label, sizeof(label), "f32 -> f32 (%s)", kernels[k]->name);
+        start = clock_sec();
+        for (int iteration = 0; iteration < BENCHMARK_AUDIO_ITERATIONS; iteration++) {
+            kernels[k]->f32_to_f32(output, f32_samples, nb_samples, 0.8f);
+            benchmark_sink += output[iteration % nb_samples];
+        }
+        print_benchmark_result(label, clock_sec() - start, total_samples);
+
+        snprintf(label, sizeof(label), "u8 -> f32 resampled (%s)", kernels[k]->name);
+        start = clock_sec();
+        for (int iteration = 0; iteration < BENCHMARK_AUDIO_ITERATIONS; iteration++) {
+            kernels[k]->u8_to_f32_resampled(output, u8_samples, BENCHMARK_AUDIO_FRAMES - 2, BENCHMARK_AUDIO_CHANNELS, 0.0, 0.999, 0.8f);
+            benchmark_sink += output[iteration % nb_samples];
+        }
+        print_benchmark_result(label, clock_sec() - start, total_samples);
+    }
+
+    start = clock_sec();
+    for (int iteration = 0; iteration < BENCHMARK_AUDIO_ITERATIONS; iteration++) {
+        kernels[1]->deinterleave_f32(planes, f32_samples, BENCHMARK_AUDIO_FRAMES, BENCHMARK_AUDIO_CHANNELS);
+        benchmark_sink += planes[0][iteration % BENCHMARK_AUDIO_FRAMES];
+    }
+    print_benchmark_result("deinterleave f32", clock_sec() - start, total_samples);
+
+    start = clock_sec();
+    for (int iteration = 0; iteration < BENCHMARK_AUDIO_ITERATIONS; iteration++) {
+        kernels[1]->interleave_f32(output, (const float* const*)planes, BENCHMARK_AUDIO_FRAMES, BENCHMARK_AUDIO_CHANNELS);
+        benchmark_sink += output[iteration % nb_samples];
+    }
+    print_benchmark_result("interleave f32", clock_sec() - start, total_samples);
+
+    free(u8_samples);
+    free(s16_samples);
+    free(f32_samples);
+    free(output);
+    for (int ch = 0; ch < BENCHMARK_AUDIO_CHANNELS; ch++) {
+        free(planes[ch]);
+    }
+}
+
+void fill_benchmark_frame(PixelData* frame, int iteration) {
+    const int nb_channels = frame->format == RGB24 ? 3 : 1;
+    for (int y = 0; y < frame->height; y++) {
+        for (int x = 0; x < frame->width; x++) {
+            uint8_t* pixel = frame->pixels + (y * frame->width + x) * nb_channels;
+            for (int ch = 0; ch < nb_channels; ch++) {
+                pixel[ch] = (uint8_t)((x * (ch + 1) + y * (3 - ch) + iteration * 2) + rand() % 8);
+            }
+        }
+    }
+}
+
+void print_encoder_result(const char* label, double seconds, size_t nb_bytes) {
+    printf("  %-32s %10.1f us/frame %10zu bytes/frame\n", label, seconds / BENCHMARK_IMAGE_ITERATIONS * 1e6, nb_bytes / BENCHMARK_IMAGE_ITERATIONS);
+}
+
+void benchmark_graphics_encoders() {
+    GraphicsBuffer* buffer = graphics_buffer_alloc();
+    PixelData* frames[2] = { pixel_data_alloc(BENCHMARK_IMAGE_WIDTH, BENCHMARK_IMAGE_HEIGHT, RGB24), pixel_data_alloc(BENCHMARK_IMAGE_WIDTH, BENCHMARK_IMAGE_HEIGHT, GRAYSCALE8) };
+    if (buffer == NULL || frames[0] == NULL || frames[1] == NULL) {
+        fprintf(stderr, "%s\n", "Could not allocate image encoder benchmark buffers");
+        if (buffer != NULL) {
+            graphics_buffer_free(buffer);
+        }
+        for (int f = 0; f < 2; f++) {
+            if (frames[f] != NULL) {
+                pixel_data_free(frames[f]);
+            }
+        }
+        return;
+    }
+
+    printf("Image encoders: %dx%d frames, %d iterations\n", BENCHMARK_IMAGE_WIDTH, BENCHMARK_IMAGE_HEIGHT, BENCHMARK_IMAGE_ITERATIONS);
+    for (int f = 0; f < 2; f++) {
+        const char* format = pixel_data_format_string(frames[f]->format);
+        const int scales[2] = { 1, BENCHMARK_SIXEL_SCALE };
+        char label[64];
+
+        for (int s = 0; s < 2; s++) {
+            size_t nb_bytes = 0;
+            double elapsed = 0.0;
+            for (int iteration = 0; iteration < BENCHMARK_IMAGE_ITERATIONS; iteration++) {
+                fill_benchmark_frame(frames[f], iteration);
+                buffer->size = 0;
+                const double start = clock_sec();
+                encode_sixel_image(buffer, frames[f], scales[s]);
+                elapsed += clock_sec() - start;
+                nb_bytes += buffer->size;
+            }
+            snprintf(label, sizeof(label), "sixel %s x%d", format, scales[s]);
+            print_encoder_result(label, elapsed, nb_bytes);
+        }
+
+        size_t nb_bytes = 0;
+        double elapsed = 0.0;
+        for (int iteration = 0; iteration < BENCHMARK_IMAGE_ITERATIONS; iteration++) {
+            fill_benchmark_frame(frames[f], iteration);
+            buffer->size = 0;
+            const double start = clock_sec();
+            encode_kitty_image(buffer, frames[f], 80, 24);
+            elapsed += clock_sec() - start;
+            nb_bytes += buffer->size;
+        }
+        snprintf(label, sizeof(label), "kitty %s", format);
+        print_encoder_result(label, elapsed, nb_bytes);
+    }
+
+    graphics_buffer_free(buffer);
+    pixel_data_free(frames[0]);
+    pixel_data_free(frames[1]);
+}
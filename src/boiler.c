@@ -119,8 +119,9 @@ VideoConverter* get_video_converter(int dst_width, int dst_height, enum AVPixelF
     converter->context = sws_getContext(
             src_width, src_height, src_pix_fmt, 
             dst_width, dst_height, dst_pix_fmt, 
-            SWS_FAST_BILINEAR, NULL, NULL, NULL);
+            SWS_AREA, NULL, NULL, NULL);
     if (converter->context == NULL) {
+        free(converter);
         return NULL;
     }
     
@@ -2,6 +2,7 @@
 #include <ncurses.h>
 #include <wmath.h>
 #include <malloc.h>
+#include <string.h>
 
 void init_color_rgb(rgb color, int init_index) {
     rgb_i32 output;
@@ -35,6 +36,10 @@ int color_map[COLOR_MAP_SIDE][COLOR_MAP_SIDE][COLOR_MAP_SIDE];
 int available_colors = 0;
 int available_color_pairs = 0;
 
+#define MAX_LAZY_COLOR_PAIRS 32767
+short lazy_color_pairs[MAX_TERMINAL_COLORS][MAX_TERMINAL_COLORS];
+int next_lazy_color_pair = 0;
+
 int get_next_nearest_perfect_square(double num) {
     double nsqrt = sqrt(num);
     if (nsqrt == (int)nsqrt) {
@@ -197,6 +202,7 @@ void initialize_color_pairs() {
         init_pair(i, get_closest_color(complementary), i);
         available_color_pairs++;
     }
+    reset_lazy_color_pairs();
 
     init_color_pairs_map();
 }
@@ -267,6 +273,29 @@ int get_closest_color_pair(rgb input) {
 }
 
 
+int get_lazy_color_pair(int fg, int bg) {
+    if (!has_colors() || fg < 0 || bg < 0 || fg >= MAX_TERMINAL_COLORS || bg >= MAX_TERMINAL_COLORS) {
+        return -1;
+    }
+
+    if (lazy_color_pairs[fg][bg] != 0) {
+        return lazy_color_pairs[fg][bg];
+    }
+
+    next_lazy_color_pair = i32max(next_lazy_color_pair, i32max(available_color_pairs, 1));
+    if (next_lazy_color_pair >= i32min(COLOR_PAIRS, MAX_LAZY_COLOR_PAIRS) || init_pair(next_lazy_color_pair, fg, bg) == ERR) {
+        return -1;
+    }
+
+    lazy_color_pairs[fg][bg] = next_lazy_color_pair;
+    return next_lazy_color_pair++;
+}
+
+void reset_lazy_color_pairs() {
+    memset(lazy_color_pairs, 0, sizeof(lazy_color_pairs));
+    next_lazy_color_pair = 0;
+}
+
 int find_best_initialized_color_pair(rgb input) {
     if (!has_colors()) {
         return -1;
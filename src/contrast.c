@@ -0,0 +1,57 @@
+#include <contrast.h>
+#include <string.h>
+
+void contrast_equalizer_init(ContrastEqualizer* equalizer) {
+    contrast_equalizer_reset(equalizer);
+}
+
+void contrast_equalizer_reset(ContrastEqualizer* equalizer) {
+    for (int i = 0; i < LUMA_HISTOGRAM_BINS; i++) {
+        equalizer->cdf[i] = (double)(i + 1) / LUMA_HISTOGRAM_BINS;
+        equalizer->lut[i] = i;
+    }
+    equalizer->primed = 0;
+    equalizer->nb_frames = 0;
+}
+
+void contrast_equalizer_update(ContrastEqualizer* equalizer, const uint32_t* histogram, int nb_samples) {
+    if (nb_samples <= 0) {
+        return;
+    }
+
+    const double clip = CONTRAST_CLIP_LIMIT * nb_samples / LUMA_HISTOGRAM_BINS;
+    double clipped[LUMA_HISTOGRAM_BINS];
+    double excess = 0.0;
+    for (int i = 0; i < LUMA_HISTOGRAM_BINS; i++) {
+        clipped[i] = histogram[i];
+        if (clipped[i] > clip) {
+            excess += clipped[i] - clip;
+            clipped[i] = clip;
+        }
+    }
+
+    const double redistributed = excess / LUMA_HISTOGRAM_BINS;
+    const double smoothing = equalizer->primed ? CONTRAST_SMOOTHING : 1.0;
+    double total = 0.0;
+    for (int i = 0; i < LUMA_HISTOGRAM_BINS; i++) {
+        total += clipped[i] + redistributed;
+        const double cdf = total / nb_samples;
+        equalizer->cdf[i] += (cdf - equalizer->cdf[i]) * smoothing;
+    }
+
+    const double low = equalizer->cdf[0];
+    const double range = equalizer->cdf[LUMA_HISTOGRAM_BINS - 1] - low;
+    for (int i = 0; i < LUMA_HISTOGRAM_BINS; i++) {
+        const double value = range > 0.0 ? (equalizer->cdf[i] - low) / range * 255.0 : i;
+        equalizer->lut[i] = value < 0.0 ? 0 : value > 255.0 ? 255 : (uint8_t)(value + 0.5);
+    }
+
+    equalizer->primed = 1;
+    equalizer->nb_frames++;
+}
+
+void contrast_equalizer_compose(ContrastEqualizer* equalizer, const uint8_t* value_lut, uint8_t* output) {
+    for (int i = 0; i < LUMA_HISTOGRAM_BINS; i++) {
+        output[i] = value_lut[equalizer->lut[i]];
+    }
+}
@@ -9,7 +9,7 @@ char* vget_formatted_string(int* output_size, const char* format, va_list args);
 int find_debug_message(MediaDebugInfo* debug_info, const char* source, const char* type, const char* desc);
 int has_debug_message(MediaDebugInfo* debug_info, const char* source, const char* type, const char* desc);
 
-const MediaDisplayMode display_modes[NUMBER_OF_DISPLAY_MODES] = { DISPLAY_MODE_VIDEO, DISPLAY_MODE_AUDIO };
+const MediaDisplayMode display_modes[NUMBER_OF_DISPLAY_MODES] = { DISPLAY_MODE_VIDEO, DISPLAY_MODE_AUDIO, DISPLAY_MODE_SPECTRUM };
 
 MediaDisplayMode get_next_display_mode(MediaDisplayMode currentMode) {
     for (int i = 0; i < NUMBER_OF_DISPLAY_MODES; i++) {
@@ -22,6 +22,7 @@ MediaDisplayMode get_next_display_mode(MediaDisplayMode currentMode) {
 
 
 void append_debug_message(MediaDebugInfo* debug_info, const char* message_source, const char* message_type, const char* message_desc, const char* format, ...) {
+    tracked_mutex_lock(&debug_info->lock);
     int to_replace = find_debug_message(debug_info, message_source, message_type, message_desc);
     va_list args;
     va_start(args, format);
@@ -33,6 +34,7 @@ void append_debug_message(MediaDebugInfo* debug_info, const char* message_source
         char* string = vget_formatted_string(&string_size, format, args);
         if (string == NULL) {
             va_end(args);
+            tracked_mutex_unlock(&debug_info->lock);
             return;
         }
 
@@ -56,16 +58,20 @@ void append_debug_message(MediaDebugInfo* debug_info, const char* message_source
     }
 
     va_end(args);
+    tracked_mutex_unlock(&debug_info->lock);
 }
 
 void add_debug_message(MediaDebugInfo* debug_info, const char* message_source, const char* message_type, const char* message_desc, const char* format, ...) {
     va_list args;
     va_start(args, format);
+    tracked_mutex_lock(&debug_info->lock);
     vadd_debug_message(debug_info, message_source, message_type, message_desc, format, args);
+    tracked_mutex_unlock(&debug_info->lock);
     va_end(args);
 }
 
 void clear_media_debug(MediaDebugInfo* debug, const char* source, const char* type) {
+    tracked_mutex_lock(&debug->lock);
     DebugMessage* saved_messages[debug->nb_messages];
     int nb_saved_messages = 0;
     for (int i = 0; i < debug->nb_messages; i++) {
@@ -82,9 +88,11 @@ void clear_media_debug(MediaDebugInfo* debug, const char* source, const char* ty
     for (int i = 0; i < nb_saved_messages; i++) {
         debug->messages[i] = saved_messages[i];
     }
+    tracked_mutex_unlock(&debug->lock);
 }
 
 void remove_debug_message(MediaDebugInfo* debug, const char* source, const char* type, const char* desc) {
+    tracked_mutex_lock(&debug->lock);
     int to_replace = find_debug_message(debug, source, type, desc);
     if (to_replace != -1) {
         free(debug->messages[to_replace]->message);
@@ -94,7 +102,7 @@ void remove_debug_message(MediaDebugInfo* debug, const char* source, const char*
         }
         debug->nb_messages--;
     }
-
+    tracked_mutex_unlock(&debug->lock);
 }
 
 int find_debug_message(MediaDebugInfo* debug_info, const char* source, const char* type, const char* desc) {
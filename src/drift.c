@@ -0,0 +1,82 @@
+#include <drift.h>
+#include <math.h>
+#include <stdio.h>
+
+void drift_controller_init(DriftController* controller) {
+    controller->nb_hard_resyncs = 0;
+    controller->history_head = 0;
+    controller->history_length = 0;
+    controller->last_history_time = 0.0;
+    drift_controller_reset(controller);
+}
+
+void drift_controller_reset(DriftController* controller) {
+    controller->drift = 0.0;
+    controller->measured = 0.0;
+    controller->sample_delta = 0;
+    controller->compensation_distance = 0;
+    controller->last_compensation_time = 0.0;
+}
+
+int drift_controller_update(DriftController* controller, double measured_drift, double current_time) {
+    controller->measured = measured_drift;
+    controller->drift += (measured_drift - controller->drift) * AUDIO_DRIFT_SMOOTHING;
+
+    if (current_time - controller->last_history_time < AUDIO_DRIFT_SAMPLE_INTERVAL_SECONDS) {
+        return 0;
+    }
+
+    controller->history[controller->history_head] = measured_drift;
+    controller->history_head = (controller->history_head + 1) % AUDIO_DRIFT_HISTORY_LENGTH;
+    controller->history_length += controller->history_length < AUDIO_DRIFT_HISTORY_LENGTH;
+    controller->last_history_time = current_time;
+    return 1;
+}
+
+int drift_controller_compensation(DriftController* controller, int sample_rate, double current_time, int* sample_delta, int* compensation_distance) {
+    if (current_time - controller->last_compensation_time < AUDIO_DRIFT_COMPENSATION_SECONDS) {
+        return 0;
+    }
+
+    const int distance = sample_rate * AUDIO_DRIFT_COMPENSATION_SECONDS;
+    const int max_delta = distance * AUDIO_DRIFT_MAX_RATIO;
+    int delta = 0;
+    if (fabs(controller->drift) > AUDIO_DRIFT_DEADBAND_SECONDS) {
+        delta = (int)lround(controller->drift * sample_rate);
+        delta = delta > max_delta ? max_delta : delta < -max_delta ? -max_delta : delta;
+    }
+
+    if (delta == 0 && controller->sample_delta == 0) {
+        return 0;
+    }
+
+    controller->sample_delta = delta;
+    controller->compensation_distance = delta != 0 ? distance : 0;
+    controller->last_compensation_time = current_time;
+    *sample_delta = controller->sample_delta;
+    *compensation_distance = controller->compensation_distance;
+    return 1;
+}
+
+int drift_controller_format(DriftController* controller, char* buffer, int buffer_size) {
+    int length = snprintf(buffer, buffer_size, "A/V drift %+.1f ms (smoothed %+.1f ms), compensating %+d samples over %d, %lu hard resyncs\n",
+            controller->measured * 1000.0, controller->drift * 1000.0, controller->sample_delta, controller->compensation_distance, controller->nb_hard_resyncs);
+
+    for (int row = 0; row < AUDIO_DRIFT_PLOT_ROWS && length < buffer_size; row++) {
+        const double row_value = AUDIO_DRIFT_PLOT_RANGE_SECONDS * (1.0 - 2.0 * row / (AUDIO_DRIFT_PLOT_ROWS - 1));
+        const double row_step = AUDIO_DRIFT_PLOT_RANGE_SECONDS / (AUDIO_DRIFT_PLOT_ROWS - 1);
+        length += snprintf(buffer + length, buffer_size - length, "%+6.0f ms |", row_value * 1000.0);
+
+        for (int i = 0; i < controller->history_length && length < buffer_size - 1; i++) {
+            const int index = (controller->history_head - controller->history_length + i + AUDIO_DRIFT_HISTORY_LENGTH) % AUDIO_DRIFT_HISTORY_LENGTH;
+            const double value = fmax(-AUDIO_DRIFT_PLOT_RANGE_SECONDS, fmin(AUDIO_DRIFT_PLOT_RANGE_SECONDS, controller->history[index]));
+            buffer[length++] = fabs(value - row_value) <= row_step / 2 ? '*' : ' ';
+        }
+
+        if (length < buffer_size - 1) {
+            buffer[length++] = '\n';
+        }
+        buffer[length < buffer_size ? length : buffer_size - 1] = '\0';
+    }
+    return length;
+}
@@ -0,0 +1,195 @@
+#include <fft.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+RealFFT* real_fft_alloc(int size) {
+    if (size < 4 || (size & (size - 1)) != 0) {
+        fprintf(stderr, "%s %d\n", "FFT size must be a power of two of at least 4, got", size);
+        return NULL;
+    }
+
+    RealFFT* fft = (RealFFT*)malloc(sizeof(RealFFT));
+    if (fft == NULL) {
+        fprintf(stderr, "%s\n", "Could not allocate FFT");
+        return NULL;
+    }
+
+    const int half = size / 2;
+    fft->size = size;
+    fft->bit_reverse = (int*)malloc(sizeof(int) * half);
+    fft->twiddle_re = (float*)malloc(sizeof(float) * half);
+    fft->twiddle_im = (float*)malloc(sizeof(float) * half);
+    fft->split_re = (float*)malloc(sizeof(float) * half);
+    fft->split_im = (float*)malloc(sizeof(float) * half);
+    fft->window = (float*)malloc(sizeof(float) * size);
+    fft->re = (float*)malloc(sizeof(float) * half);
+    fft->im = (float*)malloc(sizeof(float) * half);
+    if (fft->bit_reverse == NULL || fft->twiddle_re == NULL || fft->twiddle_im == NULL || fft->split_re == NULL ||
+            fft->split_im == NULL || fft->window == NULL || fft->re == NULL || fft->im == NULL) {
+        fprintf(stderr, "%s\n", "Could not allocate FFT tables");
+        real_fft_free(fft);
+        return NULL;
+    }
+
+    int nb_bits = 0;
+    while ((1 << nb_bits) < half) {
+        nb_bits++;
+    }
+
+    for (int i = 0; i < half; i++) {
+        int reversed = 0;
+        for (int bit = 0; bit < nb_bits; bit++) {
+            reversed |= ((i >> bit) & 1) << (nb_bits - 1 - bit);
+        }
+        fft->bit_reverse[i] = reversed;
+        fft->twiddle_re[i] = cos(2.0 * M_PI * i / half);
+        fft->twiddle_im[i] = -sin(2.0 * M_PI * i / half);
+        fft->split_re[i] = cos(2.0 * M_PI * i / size);
+        fft->split_im[i] = -sin(2.0 * M_PI * i / size);
+    }
+
+    for (int i = 0; i < size; i++) {
+        fft->window[i] = 0.5 - 0.5 * cos(2.0 * M_PI * i / size);
+    }
+    return fft;
+}
+
+void real_fft_free(RealFFT* fft) {
+    free(fft->bit_reverse);
+    free(fft->twiddle_re);
+    free(fft->twiddle_im);
+    free(fft->split_re);
+    free(fft->split_im);
+    free(fft->window);
+    free(fft->re);
+    free(fft->im);
+    free(fft);
+}
+
+void real_fft_magnitudes(RealFFT* fft, const float* input, float* magnitudes) {
+    const int half = fft->size / 2;
+    float* re = fft->re;
+    float* im = fft->im;
+
+    for (int i = 0; i < half; i++) {
+        re[fft->bit_reverse[i]] = input[2 * i] * fft->window[2 * i];
+        im[fft->bit_reverse[i]] = input[2 * i + 1] * fft->window[2 * i + 1];
+    }
+
+    for (int length = 2; length <= half; length <<= 1) {
+        const int span = length / 2;
+        const int stride = half / length;
+        for (int start = 0; start < half; start += length) {
+            for (int k = 0; k < span; k++) {
+                const float wr = fft->twiddle_re[k * stride];
+                const float wi = fft->twiddle_im[k * stride];
+                const int a = start + k, b = start + k + span;
+                const float tr = re[b] * wr - im[b] * wi;
+                const float ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+
+    const float normalization = 4.0f / fft->size;
+    for (int k = 0; k < half; k++) {
+        const int mirrored = (half - k) % half;
+        const float even_re = (re[k] + re[mirrored]) * 0.5f;
+        const float even_im = (im[k] - im[mirrored]) * 0.5f;
+        const float odd_re = (im[k] + im[mirrored]) * 0.5f;
+        const float odd_im = (re[mirrored] - re[k]) * 0.5f;
+        const float x_re = even_re + odd_re * fft->split_re[k] - odd_im * fft->split_im[k];
+        const float x_im = even_im + odd_re * fft->split_im[k] + odd_im * fft->split_re[k];
+        magnitudes[k] = sqrtf(x_re * x_re + x_im * x_im) * normalization;
+    }
+}
+
+SpectrumAnalyzer* spectrum_analyzer_alloc() {
+    SpectrumAnalyzer* analyzer = (SpectrumAnalyzer*)malloc(sizeof(SpectrumAnalyzer));
+    if (analyzer == NULL) {
+        fprintf(stderr, "%s\n", "Could not allocate spectrum analyzer");
+        return NULL;
+    }
+
+    analyzer->fft = real_fft_alloc(SPECTRUM_FFT_SIZE);
+    if (analyzer->fft == NULL) {
+        free(analyzer);
+        return NULL;
+    }
+
+    analyzer->input = (float*)malloc(sizeof(float) * SPECTRUM_FFT_SIZE);
+    analyzer->magnitudes = (float*)malloc(sizeof(float) * SPECTRUM_FFT_SIZE / 2);
+    if (analyzer->input == NULL || analyzer->magnitudes == NULL) {
+        fprintf(stderr, "%s\n", "Could not allocate spectrum analyzer buffers");
+        free(analyzer->input);
+        free(analyzer->magnitudes);
+        real_fft_free(analyzer->fft);
+        free(analyzer);
+        return NULL;
+    }
+
+    for (int b = 0; b < SPECTRUM_NB_BANDS; b++) {
+        analyzer->bands[b] = SPECTRUM_FLOOR_DB;
+        analyzer->pending_bands[b] = SPECTRUM_FLOOR_DB;
+        for (int row = 0; row < SPECTRUM_HISTORY_LENGTH; row++) {
+            analyzer->history[row][b] = SPECTRUM_FLOOR_DB;
+        }
+    }
+
+    analyzer->sample_rate = 0;
+    analyzer->enabled = 0;
+    analyzer->last_position = 0;
+    analyzer->history_head = 0;
+    analyzer->nb_hops = 0;
+    spectrum_analyzer_configure(analyzer, 44100);
+    return analyzer;
+}
+
+void spectrum_analyzer_free(SpectrumAnalyzer* analyzer) {
+    real_fft_free(analyzer->fft);
+    free(analyzer->input);
+    free(analyzer->magnitudes);
+    free(analyzer);
+}
+
+void spectrum_analyzer_configure(SpectrumAnalyzer* analyzer, int sample_rate) {
+    const int nb_bins = SPECTRUM_FFT_SIZE / 2;
+    const double nyquist = sample_rate / 2.0;
+    analyzer->sample_rate = sample_rate;
+    analyzer->band_start[0] = 1;
+    for (int b = 1; b < SPECTRUM_NB_BANDS; b++) {
+        const double frequency = SPECTRUM_MIN_FREQUENCY * pow(nyquist / SPECTRUM_MIN_FREQUENCY, (double)b / SPECTRUM_NB_BANDS);
+        const int bin = frequency * SPECTRUM_FFT_SIZE / sample_rate;
+        analyzer->band_start[b] = bin > analyzer->band_start[b - 1] ? bin : analyzer->band_start[b - 1] + 1;
+        analyzer->band_start[b] = analyzer->band_start[b] < nb_bins ? analyzer->band_start[b] : nb_bins;
+    }
+    analyzer->band_start[SPECTRUM_NB_BANDS] = nb_bins;
+}
+
+void spectrum_analyzer_process(SpectrumAnalyzer* analyzer) {
+    real_fft_magnitudes(analyzer->fft, analyzer->input, analyzer->magnitudes);
+    for (int b = 0; b < SPECTRUM_NB_BANDS; b++) {
+        float peak = 0.0f;
+        for (int bin = analyzer->band_start[b]; bin < analyzer->band_start[b + 1]; bin++) {
+            peak = analyzer->magnitudes[bin] > peak ? analyzer->magnitudes[bin] : peak;
+        }
+
+        const float decibels = 20.0f * log10f(peak > 1e-9f ? peak : 1e-9f);
+        analyzer->pending_bands[b] = decibels > SPECTRUM_FLOOR_DB ? decibels : SPECTRUM_FLOOR_DB;
+    }
+}
+
+void spectrum_analyzer_publish(SpectrumAnalyzer* analyzer) {
+    for (int b = 0; b < SPECTRUM_NB_BANDS; b++) {
+        const float decayed = analyzer->bands[b] - SPECTRUM_DECAY_DB_PER_HOP;
+        analyzer->bands[b] = analyzer->pending_bands[b] > decayed ? analyzer->pending_bands[b] : decayed;
+        analyzer->history[analyzer->history_head][b] = analyzer->pending_bands[b];
+    }
+    analyzer->history_head = (analyzer->history_head + 1) % SPECTRUM_HISTORY_LENGTH;
+    analyzer->nb_hops++;
+}
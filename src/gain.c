@@ -0,0 +1,130 @@
+#include <gain.h>
+#include <wtime.h>
+#include <wmath.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef float float4 __attribute__((vector_size(16)));
+typedef int32_t int4 __attribute__((vector_size(16)));
+
+void gain_stage_init(GainStage* stage, float gain, int sample_rate) {
+    stage->current = gain;
+    stage->target = gain;
+    stage->step = 0.0f;
+    stage->ramp_frames = i32max(1, (int)(sample_rate * GAIN_RAMP_SECONDS));
+    stage->ramp_remaining = 0;
+}
+
+void gain_stage_set_target(GainStage* stage, float target) {
+    if (target == stage->target) {
+        return;
+    }
+
+    stage->target = target;
+    stage->step = (target - stage->current) / stage->ramp_frames;
+    stage->ramp_remaining = stage->ramp_frames;
+}
+
+int gain_stage_ramp(GainStage* stage, float* samples, int nb_frames, int nb_channels, float* peak, int* nb_clipped) {
+    float ramp_peak = 0.0f;
+    int clipped = 0;
+    int frame = 0;
+
+    for (; frame < nb_frames && stage->ramp_remaining > 0; frame++) {
+        stage->current += stage->step;
+        stage->ramp_remaining--;
+        if (stage->ramp_remaining == 0) {
+            stage->current = stage->target;
+        }
+
+        for (int ch = 0; ch < nb_channels; ch++) {
+            float sample = samples[frame * nb_channels + ch] * stage->current;
+            float magnitude = fabsf(sample);
+            ramp_peak = magnitude > ramp_peak ? magnitude : ramp_peak;
+            if (magnitude > 1.0f) {
+                sample = copysignf(1.0f, sample);
+                clipped++;
+            }
+            samples[frame * nb_channels + ch] = sample;
+        }
+    }
+
+    *peak = ramp_peak;
+    *nb_clipped = clipped;
+    return frame;
+}
+
+float gain_block(float* samples, int nb_samples, float gain, int* nb_clipped) {
+    const float4 gains = { gain, gain, gain, gain };
+    const float4 ones = { 1.0f, 1.0f, 1.0f, 1.0f };
+    const int4 abs_mask = { 0x7fffffff, 0x7fffffff, 0x7fffffff, 0x7fffffff };
+    float4 peaks = { 0.0f, 0.0f, 0.0f, 0.0f };
+    int4 clips = { 0, 0, 0, 0 };
+
+    int i = 0;
+    for (; i + 4 <= nb_samples; i += 4) {
+        float4 block;
+        memcpy(&block, samples + i, sizeof(float4));
+        block *= gains;
+
+        float4 magnitude = (float4)((int4)block & abs_mask);
+        int4 louder = magnitude > peaks;
+        peaks = (float4)(((int4)peaks & ~louder) | ((int4)magnitude & louder));
+
+        int4 over = magnitude > ones;
+        float4 limit = (float4)((int4)ones | ((int4)block & ~abs_mask));
+        block = (float4)(((int4)block & ~over) | ((int4)limit & over));
+        clips -= over;
+
+        memcpy(samples + i, &block, sizeof(float4));
+    }
+
+    float peak = 0.0f;
+    int clipped = 0;
+    for (int lane = 0; lane < 4; lane++) {
+        peak = peaks[lane] > peak ? peaks[lane] : peak;
+        clipped += clips[lane];
+    }
+
+    for (; i < nb_samples; i++) {
+        float sample = samples[i] * gain;
+        float magnitude = fabsf(sample);
+        peak = magnitude > peak ? magnitude : peak;
+        if (magnitude > 1.0f) {
+            sample = copysignf(1.0f, sample);
+            clipped++;
+        }
+        samples[i] = sample;
+    }
+
+    *nb_clipped = clipped;
+    return peak;
+}
+
+void audio_meter_init(AudioMeter* meter) {
+    meter->peak = 0.0f;
+    meter->peak_hold = 0.0f;
+    meter->peak_hold_time = 0.0;
+    meter->clipped_samples = 0;
+    meter->nb_blocks = 0;
+}
+
+void audio_meter_update(AudioMeter* meter, float block_peak, int block_clipped) {
+    const double current_time = clock_sec();
+    meter->peak = block_peak;
+    meter->clipped_samples += block_clipped;
+    meter->nb_blocks++;
+
+    if (block_peak >= meter->peak_hold || current_time - meter->peak_hold_time > AUDIO_METER_PEAK_HOLD_SECONDS) {
+        meter->peak_hold = block_peak;
+        meter->peak_hold_time = current_time;
+    }
+}
+
+double audio_meter_peak_dbfs(AudioMeter* meter) {
+    return 20.0 * log10(fmax(meter->peak, 0.00001));
+}
+
+double audio_meter_hold_dbfs(AudioMeter* meter) {
+    return 20.0 * log10(fmax(meter->peak_hold, 0.00001));
+}
@@ -0,0 +1,367 @@
+#include <graphics.h>
+#include <wtime.h>
+#include <macros.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+const char* base64_alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+int da1_reports_sixel(const char* response);
+
+GraphicsProtocol probe_graphics_protocol() {
+    int fd = open("/dev/tty", O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        return GRAPHICS_PROTOCOL_NONE;
+    }
+
+    struct termios original, raw;
+    if (tcgetattr(fd, &original) != 0) {
+        close(fd);
+        return GRAPHICS_PROTOCOL_NONE;
+    }
+
+    raw = original;
+    raw.c_lflag &= ~(ICANON | ECHO);
+    raw.c_cc[VMIN] = 0;
+    raw.c_cc[VTIME] = 0;
+    tcsetattr(fd, TCSANOW, &raw);
+
+    const char query[] = "\x1b_Gi=31,s=1,v=1,a=q,t=d,f=24;AAAA\x1b\\\x1b[c";
+    if (write(fd, query, sizeof(query) - 1) < 0) {
+        tcsetattr(fd, TCSANOW, &original);
+        close(fd);
+        return GRAPHICS_PROTOCOL_NONE;
+    }
+
+    char response[512];
+    size_t length = 0;
+    response[0] = '\0';
+    const double deadline = clock_sec() + GRAPHICS_PROBE_TIMEOUT_MILLISECONDS / (double)SECONDS_TO_MILLISECONDS;
+    while (length < sizeof(response) - 1) {
+        const int remaining = (int)((deadline - clock_sec()) * SECONDS_TO_MILLISECONDS);
+        struct pollfd pending = { fd, POLLIN, 0 };
+        if (remaining <= 0 || poll(&pending, 1, remaining) <= 0) {
+            break;
+        }
+
+        const ssize_t nb_read = read(fd, response + length, sizeof(response) - 1 - length);
+        if (nb_read <= 0) {
+            break;
+        }
+        length += nb_read;
+        response[length] = '\0';
+
+        const char* da1 = strstr(response, "\x1b[?");
+        if (da1 != NULL && strchr(da1, 'c') != NULL) {
+            break;
+        }
+    }
+
+    tcsetattr(fd, TCSANOW, &original);
+    close(fd);
+
+    if (strstr(response, "\x1b_Gi=31;OK") != NULL) {
+        return GRAPHICS_PROTOCOL_KITTY;
+    } else if (da1_reports_sixel(response)) {
+        return GRAPHICS_PROTOCOL_SIXEL;
+    }
+    return GRAPHICS_PROTOCOL_NONE;
+}
+
+int da1_reports_sixel(const char* response) {
+    const char* da1 = strstr(response, "\x1b[?");
+    if (da1 == NULL) {
+        return 0;
+    }
+
+    const char* current = da1 + 3;
+    while (*current != '\0' && *current != 'c') {
+        char* end;
+        const long attribute = strtol(current, &end, 10);
+        if (end == current) {
+            return 0;
+        } else if (attribute == 4) {
+            return 1;
+        }
+        current = *end == ';' ? end + 1 : end;
+    }
+    return 0;
+}
+
+const char* graphics_protocol_string(GraphicsProtocol protocol) {
+    switch (protocol) {
+        case GRAPHICS_PROTOCOL_SIXEL: return "sixel";
+        case GRAPHICS_PROTOCOL_KITTY: return "kitty";
+        default: return "none";
+    }
+}
+
+void get_terminal_cell_pixel_size(int* width, int* height) {
+    struct winsize size;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_col > 0 && size.ws_row > 0 && size.ws_xpixel > 0 && size.ws_ypixel > 0) {
+        *width = size.ws_xpixel / size.ws_col;
+        *height = size.ws_ypixel / size.ws_row;
+        return;
+    }
+
+    *width = GRAPHICS_DEFAULT_CELL_WIDTH;
+    *height = GRAPHICS_DEFAULT_CELL_HEIGHT;
+}
+
+GraphicsBuffer* graphics_buffer_alloc() {
+    GraphicsBuffer* buffer = (GraphicsBuffer*)malloc(sizeof(GraphicsBuffer));
+    if (buffer == NULL) {
+        fprintf(stderr, "%s\n", "Could not allocate graphics buffer");
+        return NULL;
+    }
+
+    buffer->data = (char*)malloc(GRAPHICS_BUFFER_INITIAL_CAPACITY);
+    if (buffer->data == NULL) {
+        fprintf(stderr, "%s\n", "Could not allocate graphics buffer data");
+        free(buffer);
+        return NULL;
+    }
+
+    buffer->size = 0;
+    buffer->capacity = GRAPHICS_BUFFER_INITIAL_CAPACITY;
+    buffer->scratch = NULL;
+    buffer->scratch_capacity = 0;
+    return buffer;
+}
+
+void graphics_buffer_free(GraphicsBuffer* buffer) {
+    free(buffer->data);
+    free(buffer->scratch);
+    free(buffer);
+}
+
+int graphics_buffer_reserve(GraphicsBuffer* buffer, size_t size) {
+    if (buffer->size + size <= buffer->capacity) {
+        return 1;
+    }
+
+    size_t capacity = buffer->capacity;
+    while (capacity < buffer->size + size) {
+        capacity *= 2;
+    }
+
+    char* tmp = (char*)realloc(buffer->data, capacity);
+    if (tmp == NULL) {
+        fprintf(stderr, "%s\n", "Could not grow graphics buffer");
+        return 0;
+    }
+    buffer->data = tmp;
+    buffer->capacity = capacity;
+    return 1;
+}
+
+int graphics_buffer_append(GraphicsBuffer* buffer, const char* data, size_t size) {
+    if (!graphics_buffer_reserve(buffer, size)) {
+        return 0;
+    }
+
+    memcpy(buffer->data + buffer->size, data, size);
+    buffer->size += size;
+    return 1;
+}
+
+int graphics_buffer_printf(GraphicsBuffer* buffer, const char* format, ...) {
+    char formatted[128];
+    va_list args;
+    va_start(args, format);
+    const int length = vsnprintf(formatted, sizeof(formatted), format, args);
+    va_end(args);
+
+    if (length < 0 || length >= (int)sizeof(formatted)) {
+        return 0;
+    }
+    return graphics_buffer_append(buffer, formatted, length);
+}
+
+uint8_t* graphics_buffer_scratch(GraphicsBuffer* buffer, size_t size) {
+    if (size <= buffer->scratch_capacity) {
+        return buffer->scratch;
+    }
+
+    uint8_t* tmp = (uint8_t*)realloc(buffer->scratch, size);
+    if (tmp == NULL) {
+        fprintf(stderr, "%s\n", "Could not grow graphics scratch buffer");
+        return NULL;
+    }
+    buffer->scratch = tmp;
+    buffer->scratch_capacity = size;
+    return tmp;
+}
+
+uint8_t sixel_palette_index(PixelData* pixelData, int x, int y) {
+    if (pixelData->format == RGB24) {
+        const uint8_t* pixel = pixelData->pixels + (y * pixelData->width + x) * 3;
+        return (pixel[0] * SIXEL_PALETTE_SIDE / 256) * SIXEL_PALETTE_SIDE * SIXEL_PALETTE_SIDE + (pixel[1] * SIXEL_PALETTE_SIDE / 256) * SIXEL_PALETTE_SIDE + pixel[2] * SIXEL_PALETTE_SIDE / 256;
+    }
+    return pixelData->pixels[y * pixelData->width + x] * SIXEL_PALETTE_SIZE / 256;
+}
+
+int sixel_append_palette_color(GraphicsBuffer* buffer, PixelDataFormat format, int index) {
+    if (format == RGB24) {
+        const int r = index / (SIXEL_PALETTE_SIDE * SIXEL_PALETTE_SIDE);
+        const int g = (index / SIXEL_PALETTE_SIDE) % SIXEL_PALETTE_SIDE;
+        const int b = index % SIXEL_PALETTE_SIDE;
+        return graphics_buffer_printf(buffer, "#%d;2;%d;%d;%d", index, r * 100 / (SIXEL_PALETTE_SIDE - 1), g * 100 / (SIXEL_PALETTE_SIDE - 1), b * 100 / (SIXEL_PALETTE_SIDE - 1));
+    }
+
+    const int gray = index * 100 / (SIXEL_PALETTE_SIZE - 1);
+    return graphics_buffer_printf(buffer, "#%d;2;%d;%d;%d", index, gray, gray, gray);
+}
+
+int sixel_append_run(GraphicsBuffer* buffer, char sixel, int run) {
+    if (run > 3) {
+        return graphics_buffer_printf(buffer, "!%d%c", run, sixel);
+    }
+
+    char repeated[3] = { sixel, sixel, sixel };
+    return graphics_buffer_append(buffer, repeated, run);
+}
+
+int encode_sixel_image(GraphicsBuffer* buffer, PixelData* pixelData, int scale) {
+    scale = scale > 0 ? scale : 1;
+    const int width = pixelData->width * scale;
+    const int height = pixelData->height * scale;
+    uint8_t* scratch = graphics_buffer_scratch(buffer, (size_t)pixelData->width * pixelData->height + (size_t)SIXEL_PALETTE_SIZE * width);
+    if (scratch == NULL) {
+        return 0;
+    }
+
+    uint8_t* indices = scratch;
+    uint8_t* masks = scratch + (size_t)pixelData->width * pixelData->height;
+    int used[SIXEL_PALETTE_SIZE] = { 0 };
+    for (int y = 0; y < pixelData->height; y++) {
+        for (int x = 0; x < pixelData->width; x++) {
+            const uint8_t index = sixel_palette_index(pixelData, x, y);
+            indices[y * pixelData->width + x] = index;
+            used[index] = 1;
+        }
+    }
+
+    int success = graphics_buffer_printf(buffer, "\x1bP0;1;0q\"1;1;%d;%d", width, height);
+    for (int i = 0; i < SIXEL_PALETTE_SIZE && success; i++) {
+        if (used[i]) {
+            success = sixel_append_palette_color(buffer, pixelData->format, i);
+        }
+    }
+
+    int band_colors[SIXEL_PALETTE_SIZE];
+    for (int band = 0; band < height && success; band += SIXEL_BAND_HEIGHT) {
+        int nb_band_colors = 0;
+        int in_band[SIXEL_PALETTE_SIZE] = { 0 };
+        for (int bit = 0; bit < SIXEL_BAND_HEIGHT && band + bit < height; bit++) {
+            const uint8_t* row = indices + ((band + bit) / scale) * pixelData->width;
+            for (int x = 0; x < width; x++) {
+                const uint8_t index = row[x / scale];
+                if (!in_band[index]) {
+                    in_band[index] = 1;
+                    band_colors[nb_band_colors++] = index;
+                    memset(masks + (size_t)index * width, 0, width);
+                }
+                masks[(size_t)index * width + x] |= 1 << bit;
+            }
+        }
+
+        for (int c = 0; c < nb_band_colors && success; c++) {
+            const uint8_t* mask = masks + (size_t)band_colors[c] * width;
+            int last = width - 1;
+            while (last >= 0 && mask[last] == 0) {
+                last--;
+            }
+
+            success = graphics_buffer_printf(buffer, "#%d", band_colors[c]);
+            for (int x = 0; x <= last && success;) {
+                int run = 1;
+                while (x + run <= last && mask[x + run] == mask[x]) {
+                    run++;
+                }
+                success = sixel_append_run(buffer, (char)(mask[x] + '?'), run);
+                x += run;
+            }
+            success = success && graphics_buffer_append(buffer, c + 1 < nb_band_colors ? "$" : "-", 1);
+        }
+    }
+
+    return success && graphics_buffer_append(buffer, "\x1b\\", 2);
+}
+
+int encode_kitty_image(GraphicsBuffer* buffer, PixelData* pixelData, int columns, int rows) {
+    const size_t nb_bytes = (size_t)pixelData->width * pixelData->height * 3;
+    const uint8_t* raw = pixelData->pixels;
+    if (pixelData->format != RGB24) {
+        uint8_t* expanded = graphics_buffer_scratch(buffer, nb_bytes);
+        if (expanded == NULL) {
+            return 0;
+        }
+
+        for (int i = 0; i < pixelData->width * pixelData->height; i++) {
+            expanded[i * 3] = expanded[i * 3 + 1] = expanded[i * 3 + 2] = pixelData->pixels[i];
+        }
+        raw = expanded;
+    }
+
+    const size_t chunk_raw_bytes = KITTY_CHUNK_BYTES / 4 * 3;
+    int success = 1;
+    for (size_t offset = 0; offset < nb_bytes && success; offset += chunk_raw_bytes) {
+        const size_t chunk_bytes = nb_bytes - offset < chunk_raw_bytes ? nb_bytes - offset : chunk_raw_bytes;
+        const int more = offset + chunk_bytes < nb_bytes;
+        if (offset == 0) {
+            success = graphics_buffer_printf(buffer, "\x1b_Ga=T,i=%d,p=1,f=24,s=%d,v=%d,c=%d,r=%d,C=1,q=2,m=%d;",
+                    KITTY_IMAGE_ID, pixelData->width, pixelData->height, columns, rows, more);
+        } else {
+            success = graphics_buffer_printf(buffer, "\x1b_Gm=%d;", more);
+        }
+
+        if (!success || !graphics_buffer_reserve(buffer, KITTY_CHUNK_BYTES + 2)) {
+            return 0;
+        }
+
+        char* out = buffer->data + buffer->size;
+        const uint8_t* in = raw + offset;
+        size_t i = 0;
+        for (; i + 3 <= chunk_bytes; i += 3) {
+            const uint32_t triple = (uint32_t)in[i] << 16 | (uint32_t)in[i + 1] << 8 | in[i + 2];
+            *out++ = base64_alphabet[(triple >> 18) & 0x3F];
+            *out++ = base64_alphabet[(triple >> 12) & 0x3F];
+            *out++ = base64_alphabet[(triple >> 6) & 0x3F];
+            *out++ = base64_alphabet[triple & 0x3F];
+        }
+
+        if (i < chunk_bytes) {
+            const uint32_t triple = (uint32_t)in[i] << 16 | (i + 1 < chunk_bytes ? (uint32_t)in[i + 1] << 8 : 0);
+            *out++ = base64_alphabet[(triple >> 18) & 0x3F];
+            *out++ = base64_alphabet[(triple >> 12) & 0x3F];
+            *out++ = i + 1 < chunk_bytes ? base64_alphabet[(triple >> 6) & 0x3F] : '=';
+            *out++ = '=';
+        }
+        buffer->size = out - buffer->data;
+        success = graphics_buffer_append(buffer, "\x1b\\", 2);
+    }
+
+    return success;
+}
+
+void write_graphics_image(GraphicsBuffer* buffer, int y, int x) {
+    printf("\x1b" "7" "\x1b[%d;%dH", y + 1, x + 1);
+    fwrite(buffer->data, 1, buffer->size, stdout);
+    printf("\x1b" "8");
+    fflush(stdout);
+}
+
+void clear_graphics_images(GraphicsProtocol protocol) {
+    if (protocol == GRAPHICS_PROTOCOL_KITTY) {
+        printf("\x1b_Ga=d,d=I,i=%d,q=2\x1b\\", KITTY_IMAGE_ID);
+        fflush(stdout);
+    }
+}
@@ -20,54 +20,12 @@
 #include <libavutil/fifo.h>
 #include <libavutil/audio_fifo.h>
 
-#define NUMBER_OF_VIDEO_ICONS 27
-#define NUMBER_OF_PLAYBACK_ICONS 12
-#define NUMBER_OF_NUMBER_ICONS 10
-#define NUMBER_OF_NUMBER_SYMBOL_ICONS 5
-
 #define NUMBER_OF_VOLUME_ICONS 4
 
 const VideoIcon videoIcons[NUMBER_OF_VIDEO_ICONS] = { STOP_ICON, PLAY_ICON, PAUSE_ICON, FORWARD_ICON, BACKWARD_ICON, MUTE_ICON, NO_VOLUME_ICON, LOW_VOLUME_ICON, MEDIUM_VOLUME_ICON, HIGH_VOLUME_ICON, MAXIMIZED_ICON, MINIMIZED_ICON, ZERO_ICON, ONE_ICON, TWO_ICON, THREE_ICON, FOUR_ICON, FIVE_ICON, SIX_ICON, SEVEN_ICON, EIGHT_ICON, NINE_ICON, POINT_ICON, TIMES_ICON, DIVIDE_ICON, PLUS_ICON, MINUS_ICON };
 
-const VideoIcon playbackIconOrder[NUMBER_OF_PLAYBACK_ICONS] = { 
-    STOP_ICON,
-    PLAY_ICON,
-    FORWARD_ICON,
-    BACKWARD_ICON,
-    PAUSE_ICON,
-    NO_VOLUME_ICON,
-    LOW_VOLUME_ICON,
-    MEDIUM_VOLUME_ICON,
-    HIGH_VOLUME_ICON,
-    MUTE_ICON,
-    MAXIMIZED_ICON,
-    MINIMIZED_ICON,
-};
-
-const VideoIcon numberIconOrder[NUMBER_OF_NUMBER_ICONS] = {
-   ONE_ICON,
-   TWO_ICON,
-   THREE_ICON,
-   FOUR_ICON,
-   FIVE_ICON,
-   SIX_ICON,
-   SEVEN_ICON,
-   EIGHT_ICON,
-   NINE_ICON
-};
-
-const VideoIcon numberSymbolIconOrder[NUMBER_OF_NUMBER_SYMBOL_ICONS] = {
-    POINT_ICON,
-    TIMES_ICON,
-    PLUS_ICON,
-    DIVIDE_ICON,
-    MINUS_ICON
-};
-
 const VideoIcon volumeIcons[NUMBER_OF_VOLUME_ICONS] = { NO_VOLUME_ICON, LOW_VOLUME_ICON, MEDIUM_VOLUME_ICON, HIGH_VOLUME_ICON };
 
-PixelData* icons[NUMBER_OF_VIDEO_ICONS] = {NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
-
 
 VideoIcon iconFromDigit(int digit) {
     switch (digit % 10) {
@@ -90,7 +48,7 @@ int initialized = 0;
 int testIconProgram() {
     for (int i = 0; i < 12; i++) {
         erase();
-        PixelData* iconData = icons[i];
+        PixelData* iconData = get_video_icon(videoIcons[i]);
         AsciiImage* image = get_ascii_image_bounded(iconData, COLS, LINES);
         if (image != NULL) {
             print_ascii_image_full(image);
@@ -104,104 +62,37 @@ int testIconProgram() {
     return EXIT_SUCCESS;
 }
 
-int read_sprite_sheet(PixelData** buffer, int bufferSize, PixelData* iconData, int rows, int cols, int spriteWidth, int spriteHeight) {
-
-    for (int i = 0; i < i32min(bufferSize, rows * cols); i++) {
-        PixelData* icon = pixel_data_alloc(spriteWidth, spriteHeight, GRAYSCALE8);
-        int currentSpriteY = i / cols * spriteHeight;
-        int currentSpriteX = i % cols * spriteWidth;
-        for (int row = 0; row < spriteHeight; row++) {
-            for (int col = 0; col < spriteWidth; col++) {
-                icon->pixels[row * spriteWidth + col] = iconData->pixels[(currentSpriteY + row) * (spriteWidth * cols) + (currentSpriteX + col)];
-            }
-        }
-        buffer[i] = icon;
-    }
-
-    return 1;
-}
-
 int init_icons() {
-    if (!initialized) {
-        bool success;
-        PixelData* playbackIconBuffer[NUMBER_OF_PLAYBACK_ICONS];
-        PixelData* numberIconBuffer[NUMBER_OF_NUMBER_ICONS];
-        PixelData* numberSymbolBuffer[NUMBER_OF_NUMBER_SYMBOL_ICONS];
-
-        PixelData* playbackIcons = get_playback_icons_pixel_data();
-        PixelData* numberIcons = get_number_icons_pixel_data();
-        PixelData* numberSymbolIcons = get_number_symbols_icons_pixel_data();
-
-        success = read_sprite_sheet(playbackIconBuffer, NUMBER_OF_PLAYBACK_ICONS, playbackIcons, ICONS_SPRITE_ROWS, ICONS_SPRITE_COLUMNS, ICONS_SPRITE_WIDTH, ICONS_SPRITE_HEIGHT);
-        if (!success) {
-            fprintf(stderr, "%s\n", "Could Not initialize playback icons");
-            pixel_data_free(playbackIcons);
-            pixel_data_free(numberIcons);
-            pixel_data_free(numberSymbolIcons);
-            return 0;
-        }
-
-        for (int i = 0; i < NUMBER_OF_PLAYBACK_ICONS; i++) {
-            icons[playbackIconOrder[i]] = playbackIconBuffer[i];
-        }
-
-        success = read_sprite_sheet(numberIconBuffer, NUMBER_OF_NUMBER_ICONS, numberIcons, NUMBERS_SPRITE_ROWS, NUMBERS_SPRITE_COLUMNS, NUMBERS_SPRITE_WIDTH, NUMBERS_SPRITE_HEIGHT);
-        if (!success) {
-            fprintf(stderr, "%s\n", "Could Not initialize number icons");
-            pixel_data_free(playbackIcons);
-            pixel_data_free(numberIcons);
-            pixel_data_free(numberSymbolIcons);
-            return 0;
-        }
-
-        for (int i = 0; i < NUMBER_OF_NUMBER_ICONS; i++) {
-            icons[numberIconOrder[i]] = numberIconBuffer[i];
-        }
-
-        success = read_sprite_sheet(numberSymbolBuffer, NUMBER_OF_NUMBER_SYMBOL_ICONS, numberSymbolIcons, NUMBER_SYMBOLS_SPRITE_ROWS, NUMBER_SYMBOLS_SPRITE_COLUMNS, NUMBER_SYMBOLS_SPRITE_WIDTH, NUMBER_SYMBOLS_SPRITE_HEIGHT);
-        if (!success) {
-            fprintf(stderr, "%s\n", "Could Not initialize number symbol icons");
-            pixel_data_free(playbackIcons);
-            pixel_data_free(numberIcons);
-            pixel_data_free(numberSymbolIcons);
-            return 0;
-        }
-
-        for (int i = 0; i < NUMBER_OF_NUMBER_SYMBOL_ICONS; i++) {
-            icons[numberSymbolIconOrder[i]] = numberSymbolBuffer[i];
-        }
-
-        initialized = 1;
-    }
-
-    printf("%s\n", "All Icons Initialized");
+    initialized = 1;
     return initialized;
 }
 
 int free_icons() {
-    if (initialized) {
-        for (int i = 0; i < NUMBER_OF_VIDEO_ICONS; i++) {
-            if (icons[i] != NULL) {
-                pixel_data_free(icons[i]);
-            }
-        }
-        initialized = 0;
-    }
+    initialized = 0;
     return !initialized;
 }
 
 PixelData* get_video_icon(VideoIcon iconEnum) {
-    if (icons[iconEnum] != NULL) {
-        return icons[iconEnum];
-    } else {
-        if (initialized) {
-            fprintf(stderr, "%s %d %s\n", "ERROR: ICON ENUM ", iconEnum, " NOT INITIALIZED ");
-        } else {
-            fprintf(stderr, "%s\n", "ICONS NOT INITIALIZED");
-        }
-
+    if (iconEnum < 0 || iconEnum >= NUMBER_OF_VIDEO_ICONS) {
+        fprintf(stderr, "%s %d %s\n", "ERROR: ICON ENUM ", iconEnum, " OUT OF RANGE ");
         return NULL;
     }
+
+    return &icon_atlas[iconEnum][0];
+}
+
+PixelData* get_video_icon_fitted(PixelData* icon, int maxWidth, int maxHeight) {
+    if (icon < &icon_atlas[0][0] || icon >= &icon_atlas[0][0] + NUMBER_OF_VIDEO_ICONS * ICON_ATLAS_NB_SIZES) {
+        return icon;
+    }
+
+    PixelData* sizes = icon_atlas[(icon - &icon_atlas[0][0]) / ICON_ATLAS_NB_SIZES];
+    for (int i = 0; i < ICON_ATLAS_NB_SIZES; i++) {
+        if (sizes[i].width <= maxWidth && sizes[i].height <= maxHeight) {
+            return &sizes[i];
+        }
+    }
+    return &sizes[ICON_ATLAS_NB_SIZES - 1];
 }
 
 VideoSymbol* get_video_symbol(VideoIcon iconEnum) {
@@ -242,6 +133,74 @@ int get_video_symbol_current_frame(VideoSymbol* symbol) {
     return  ((clock_sec() - symbol->startTime) / symbol->lifeTime) * (double)symbol->frames; 
 }
 
+OverlayCache* overlay_cache_alloc() {
+    OverlayCache* cache = (OverlayCache*)malloc(sizeof(OverlayCache));
+    if (cache == NULL) {
+        fprintf(stderr, "%s\n", "Could not allocate overlay cache");
+        return NULL;
+    }
+
+    cache->nb_entries = 0;
+    cache->clock = 0;
+    cache->nb_hits = 0;
+    cache->nb_misses = 0;
+    return cache;
+}
+
+void overlay_cache_clear(OverlayCache* cache) {
+    for (int i = 0; i < cache->nb_entries; i++) {
+        ascii_image_free(cache->entries[i].image);
+    }
+    cache->nb_entries = 0;
+}
+
+void overlay_cache_free(OverlayCache* cache) {
+    overlay_cache_clear(cache);
+    free(cache);
+}
+
+AsciiImage* overlay_cache_get(OverlayCache* cache, PixelData* source, int maxWidth, int maxHeight, int colored) {
+    const GlyphRamp* ramp = get_active_glyph_ramp();
+    cache->clock++;
+    for (int i = 0; i < cache->nb_entries; i++) {
+        OverlayCacheEntry* entry = &cache->entries[i];
+        if (entry->source == source && entry->max_width == maxWidth && entry->max_height == maxHeight && entry->colored == colored && entry->ramp == ramp) {
+            entry->last_used = cache->clock;
+            cache->nb_hits++;
+            return entry->image;
+        }
+    }
+
+    FrameArena* arena = frame_arena_bind(NULL);
+    AsciiImage* image = get_ascii_image_bounded(get_video_icon_fitted(source, maxWidth, maxHeight), maxWidth, maxHeight);
+    if (image != NULL && colored && !ascii_init_color(image)) {
+        ascii_image_free(image);
+        image = NULL;
+    }
+    frame_arena_bind(arena);
+
+    if (image == NULL) {
+        return NULL;
+    }
+
+    int slot = cache->nb_entries;
+    if (cache->nb_entries == OVERLAY_CACHE_SIZE) {
+        slot = 0;
+        for (int i = 1; i < cache->nb_entries; i++) {
+            if (cache->entries[i].last_used < cache->entries[slot].last_used) {
+                slot = i;
+            }
+        }
+        ascii_image_free(cache->entries[slot].image);
+    } else {
+        cache->nb_entries++;
+    }
+
+    cache->entries[slot] = (OverlayCacheEntry){ source, maxWidth, maxHeight, colored, ramp, image, cache->clock };
+    cache->nb_misses++;
+    return image;
+}
+
 
 /* PixelData* get_stitched_image(PixelData** images) { */
 /*     PixelData* pixelData = (PixelData*)malloc(sizeof(PixelData)); */
@@ -143,12 +143,21 @@ const char* pixel_data_format_string(PixelDataFormat format) {
 
 PixelData* copy_pixel_data(PixelData* data) {
     PixelData* new_data = pixel_data_alloc(data->width, data->height, data->format);
-    for (int i = 0; i < get_pixel_data_buffer_size(data); i++) {
-        new_data->pixels[i] = data->pixels[i];
+    if (new_data == NULL) {
+        return NULL;
     }
+    memcpy(new_data->pixels, data->pixels, get_pixel_data_buffer_size(data));
     return new_data;
 }
 
+int copy_pixel_data_into(PixelData* destination, PixelData* source) {
+    if (destination->width != source->width || destination->height != source->height || destination->format != source->format) {
+        return 0;
+    }
+    memcpy(destination->pixels, source->pixels, get_pixel_data_buffer_size(source));
+    return 1;
+}
+
 int get_pixel_data_buffer_size(PixelData* data) {
     switch (data->format) {
         case RGB24: return data->width * data->height * 3 * sizeof(uint8_t);
@@ -180,23 +189,29 @@ PixelDataFormat AVPixelFormat_to_PixelDataFormat(enum AVPixelFormat format) {
 }
 
 PixelData* pixel_data_alloc(int width, int height, PixelDataFormat format) {
-  PixelData* pixelData = (PixelData*)malloc(sizeof(PixelData));
+  FrameArena* arena;
+  PixelData* pixelData = (PixelData*)frame_arena_malloc(sizeof(PixelData), &arena);
+  if (pixelData == NULL) {
+      return NULL;
+  }
   pixelData->width = width;
   pixelData->height = height;
   pixelData->format = format;
+  pixelData->arena = arena;
   int buffer_size = get_pixel_data_buffer_size(pixelData);
-  pixelData->pixels = (uint8_t*)malloc(buffer_size);
-
-  for (int i = 0; i < buffer_size; i++) {
-      pixelData->pixels[i] = (uint8_t)0;
+  pixelData->pixels = (uint8_t*)frame_arena_malloc(buffer_size, &arena);
+  if (pixelData->pixels == NULL) {
+      frame_arena_release(pixelData, arena);
+      return NULL;
   }
 
+  memset(pixelData->pixels, 0, buffer_size);
   return pixelData;
 }
 
 void pixel_data_free(PixelData* pixelData) {
-  free(pixelData->pixels);
-  free(pixelData);
+  frame_arena_release(pixelData->pixels, pixelData->arena);
+  frame_arena_release(pixelData, pixelData->arena);
 }
 
 int pixel_data_equals(PixelData* first, PixelData* second) {
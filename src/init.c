@@ -5,6 +5,13 @@
 #include <media.h>
 #include <wtime.h>
 
+typedef struct PlayerThreadSpec {
+    const char* name;
+    void* (*routine)(void*);
+} PlayerThreadSpec;
+
+int run_media_player(MediaPlayer* player, const PlayerThreadSpec* threads, int nb_threads, void (*ui_loop)(MediaPlayer*), int initial_packets);
+
 int start_media_player_from_filename(const char* fileName) {
     MediaPlayer* player = media_player_alloc(fileName);
     if (player != NULL) {
@@ -17,69 +24,76 @@ int start_media_player_from_filename(const char* fileName) {
 }
 
 int start_media_player(MediaPlayer* player) {
+    const PlayerThreadSpec threads[] = {
+        { "video", video_playback_thread },
+        { "audio", audio_playback_thread },
+        { "loading", data_loading_thread },
+    };
+    return run_media_player(player, threads, sizeof(threads) / sizeof(PlayerThreadSpec), render_loop, 5000);
+}
+
+int start_audio_player(MediaPlayer* player) {
     if (player->inUse) {
         fprintf(stderr, "%s","CANNOT USE MEDIA PLAYER THAT IS ALREADY IN USE");
         return 0;
     }
 
-    player->inUse = 1;
-    player->timeline->playback->playing = 1;
-    player->timeline->playback->start_time = clock_sec();
-    fetch_next(player->timeline->mediaData, 5000);
-
-    pthread_mutex_t alterMutex;
-    pthread_mutex_init(&alterMutex, NULL);
-
-    MediaThreadData data = { player, &alterMutex };
-    pthread_t video_thread, audio_thread, buffer_thread;
-    int success = 1;
-    int error;
-
-    error = pthread_create(&video_thread, NULL, video_playback_thread, (void*)&data);
-    if (error) {
-        fprintf(stderr, "%s\n" ,"Failed to create video thread");
-        success = 0;
-        player->inUse = 0;
+    MediaData* media_data = player->timeline->mediaData;
+    if (!has_media_stream(media_data, AVMEDIA_TYPE_AUDIO)) {
+        fprintf(stderr, "%s\n", "Cannot play audio only: file has no audio stream");
+        return 0;
     }
 
-    error = pthread_create(&audio_thread, NULL, audio_playback_thread, (void*)&data);
-    if (error) {
-        fprintf(stderr, "%s\n" ,"Failed to create audio thread");
-        success = 0;
-        player->inUse = 0;
+    for (int i = 0; i < media_data->nb_streams; i++) {
+        if (media_data->media_streams[i]->info->mediaType != AVMEDIA_TYPE_AUDIO) {
+            media_data->media_streams[i]->disabled = 1;
+            media_data->media_streams[i]->info->stream->discard = AVDISCARD_ALL;
+        }
     }
 
-    error = pthread_create(&buffer_thread, NULL, data_loading_thread, (void*)&data);
-    if (error) {
-        fprintf(stderr, "%s\n" ,"Failed to create loading thread");
-        success = 0;
-        player->inUse = 0;
-    }
-    render_loop(player, &alterMutex);
+    const PlayerThreadSpec threads[] = {
+        { "audio", audio_playback_thread },
+        { "loading", data_loading_thread },
+    };
+    return run_media_player(player, threads, sizeof(threads) / sizeof(PlayerThreadSpec), audio_status_loop, 500);
+}
 
-    error = pthread_join(video_thread, NULL);
-    if (error) {
-        fprintf(stderr, "%s\n", "Failed to join video thread");
-        success = 0;
-        player->inUse = 0;
+int run_media_player(MediaPlayer* player, const PlayerThreadSpec* threads, int nb_threads, void (*ui_loop)(MediaPlayer*), int initial_packets) {
+    if (player->inUse) {
+        fprintf(stderr, "%s","CANNOT USE MEDIA PLAYER THAT IS ALREADY IN USE");
+        return 0;
     }
 
-    error = pthread_join(audio_thread, NULL);
-    if (error) {
-        fprintf(stderr, "%s\n", "Failed to join audio thread");
-        success = 0;
-        player->inUse = 0;
+    player->inUse = 1;
+    player->timeline->playback->playing = 1;
+    player->timeline->playback->start_time = clock_sec();
+    fetch_next(player->timeline->mediaData, initial_packets);
+
+    MediaThreadData data = { player };
+    pthread_t thread_ids[nb_threads];
+    int started[nb_threads];
+    int success = 1;
+
+    for (int i = 0; i < nb_threads; i++) {
+        started[i] = pthread_create(&thread_ids[i], NULL, threads[i].routine, (void*)&data) == 0;
+        if (!started[i]) {
+            fprintf(stderr, "%s %s %s\n", "Failed to create", threads[i].name, "thread");
+            success = 0;
+            player->inUse = 0;
+        }
     }
+    ui_loop(player);
+    player_state_notify(player->state);
 
-    error = pthread_join(buffer_thread, NULL);
-    if (error) {
-        fprintf(stderr, "%s\n", "Failed to join loading thread");
-        success = 0;
-        player->inUse = 0;
+    for (int i = 0; i < nb_threads; i++) {
+        if (started[i] && pthread_join(thread_ids[i], NULL)) {
+            fprintf(stderr, "%s %s %s\n", "Failed to join", threads[i].name, "thread");
+            success = 0;
+            player->inUse = 0;
+        }
     }
 
-    player->timeline->playback->playing = 0;
+    playback_set_playing(player->timeline->playback, 0);
     player->inUse = 0;
-    pthread_mutex_destroy(&alterMutex);
     return success;
 }
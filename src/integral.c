@@ -0,0 +1,128 @@
+#include <integral.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+IntegralImage* integral_image_alloc(uint8_t* pixels, int width, int height, PixelDataFormat format) {
+    if (width <= 0 || height <= 0 || (int64_t)width * height > INTEGRAL_IMAGE_MAX_PIXELS) {
+        fprintf(stderr, "%s %dx%d\n", "Cannot build 32-bit integral image of size", width, height);
+        return NULL;
+    }
+
+    FrameArena* arena;
+    IntegralImage* integral = (IntegralImage*)frame_arena_malloc(sizeof(IntegralImage), &arena);
+    if (integral == NULL) {
+        fprintf(stderr, "%s\n", "Could not allocate integral image");
+        return NULL;
+    }
+
+    integral->width = width;
+    integral->height = height;
+    integral->stride = width + 1;
+    integral->format = format;
+    integral->arena = arena;
+    const size_t nb_entries = (size_t)integral->stride * (height + 1);
+
+    integral->luma = (uint32_t*)frame_arena_malloc(nb_entries * sizeof(uint32_t), &arena);
+    if (integral->luma == NULL) {
+        fprintf(stderr, "%s\n", "Could not allocate integral image luma table");
+        frame_arena_release(integral, arena);
+        return NULL;
+    }
+    memset(integral->luma, 0, integral->stride * sizeof(uint32_t));
+
+    integral->color = NULL;
+    if (format == RGB24) {
+        integral->color = (uint32_t*)frame_arena_malloc(nb_entries * 3 * sizeof(uint32_t), &arena);
+        if (integral->color == NULL) {
+            fprintf(stderr, "%s\n", "Could not allocate integral image color table");
+            frame_arena_release(integral->luma, arena);
+            frame_arena_release(integral, arena);
+            return NULL;
+        }
+        memset(integral->color, 0, integral->stride * 3 * sizeof(uint32_t));
+    }
+
+    const int stride = integral->stride;
+    for (int row = 0; row < height; row++) {
+        uint32_t* above = integral->luma + row * stride;
+        uint32_t* current = integral->luma + (row + 1) * stride;
+        uint32_t line = 0;
+        current[0] = 0;
+
+        if (format == GRAYSCALE8) {
+            const uint8_t* source = pixels + row * width;
+            for (int col = 0; col < width; col++) {
+                line += source[col];
+                current[col + 1] = above[col + 1] + line;
+            }
+        } else {
+            const uint8_t* source = pixels + row * width * 3;
+            uint32_t* color_above = integral->color + row * stride * 3;
+            uint32_t* color_current = integral->color + (row + 1) * stride * 3;
+            uint32_t color_line[3] = { 0, 0, 0 };
+            memset(color_current, 0, 3 * sizeof(uint32_t));
+            for (int col = 0; col < width; col++) {
+                line += get_grayscale(source[col * 3], source[col * 3 + 1], source[col * 3 + 2]);
+                current[col + 1] = above[col + 1] + line;
+                for (int channel = 0; channel < 3; channel++) {
+                    color_line[channel] += source[col * 3 + channel];
+                    color_current[(col + 1) * 3 + channel] = color_above[(col + 1) * 3 + channel] + color_line[channel];
+                }
+            }
+        }
+    }
+
+    return integral;
+}
+
+IntegralImage* integral_image_alloc_from_pixel_data(PixelData* pixelData) {
+    return integral_image_alloc(pixelData->pixels, pixelData->width, pixelData->height, pixelData->format);
+}
+
+void integral_image_free(IntegralImage* integral) {
+    frame_arena_release(integral->luma, integral->arena);
+    if (integral->color != NULL) {
+        frame_arena_release(integral->color, integral->arena);
+    }
+    frame_arena_release(integral, integral->arena);
+}
+
+void integral_image_cell_span(int index, int count, int size, int* start, int* end) {
+    *start = (int)((int64_t)index * size / count);
+    *end = (int)((int64_t)(index + 1) * size / count);
+    if (*end <= *start) {
+        *end = *start + 1 < size ? *start + 1 : size;
+        *start = *end - 1;
+    }
+}
+
+uint8_t integral_image_avg_luma(IntegralImage* integral, int x0, int y0, int x1, int y1) {
+    const int area = (x1 - x0) * (y1 - y0);
+    if (area <= 0) {
+        return 0;
+    }
+
+    const uint32_t* table = integral->luma;
+    const int stride = integral->stride;
+    const uint32_t sum = table[y1 * stride + x1] - table[y0 * stride + x1] - table[y1 * stride + x0] + table[y0 * stride + x0];
+    return sum / area;
+}
+
+void integral_image_avg_rgb(IntegralImage* integral, int x0, int y0, int x1, int y1, rgb output) {
+    const int area = (x1 - x0) * (y1 - y0);
+    if (area <= 0 || integral->color == NULL) {
+        rgb_set(output, 0, 0, 0);
+        return;
+    }
+
+    const uint32_t* table = integral->color;
+    const int stride = integral->stride * 3;
+    uint8_t channels[3];
+    for (int channel = 0; channel < 3; channel++) {
+        const uint32_t sum = table[y1 * stride + x1 * 3 + channel] - table[y0 * stride + x1 * 3 + channel]
+            - table[y1 * stride + x0 * 3 + channel] + table[y0 * stride + x0 * 3 + channel];
+        channels[channel] = sum / area;
+    }
+    rgb_set(output, channels[0], channels[1], channels[2]);
+}
@@ -1,67 +1,271 @@
 #include <curses.h>
 #include <libavutil/avutil.h>
 #include <pthread.h>
+#include <stdlib.h>
 #include <loader.h>
 #include <media.h>
 #include <macros.h>
 #include <threads.h>
+#include <wtime.h>
+
+const char* debug_loader_source = "loader";
+const char* debug_loader_type = "debug";
+
+void report_loader_status(MediaData* media_data, MediaDebugInfo* debug_info);
 
 void* data_loading_thread(void* args) {
     MediaThreadData* thread_data = (MediaThreadData*)args;
     MediaPlayer* player = thread_data->player;
-    pthread_mutex_t* alterMutex = thread_data->alterMutex;
 
-    int shouldFetch = 1;
+    int filling = 1;
     MediaData* media_data = player->timeline->mediaData;
+    PlayerState* state = player->state;
+    double last_report_time = 0.0;
 
-    while (!player->timeline->mediaData->allPacketsRead) {
-        pthread_mutex_lock(alterMutex);
-        shouldFetch = 1;
+    while (player->inUse) {
+        player_state_count_wakeup(state, PLAYER_THREAD_LOADER);
+        unsigned long seen_generation = player_state_generation(state);
 
+        int any_starving = 0;
+        int all_satisfied = 1;
+        int over_memory = 0;
         for (int i = 0; i < media_data->nb_streams; i++) {
-            if (selection_list_length(media_data->media_streams[i]->packets) > PACKET_RESERVE_SIZE) {
-                shouldFetch = 0;
-                break;
+            MediaStream* stream = media_data->media_streams[i];
+            if (media_stream_is_discarded(stream)) {
+                continue;
             }
+
+            tracked_mutex_lock(&stream->lock);
+            const double buffered_seconds = media_stream_buffered_seconds(stream);
+            const size_t buffered_bytes = media_stream_buffered_bytes(stream);
+            tracked_mutex_unlock(&stream->lock);
+
+            any_starving |= buffered_seconds < LOADER_LOW_WATERMARK_SECONDS && buffered_bytes < LOADER_LOW_WATERMARK_BYTES;
+            all_satisfied &= buffered_seconds >= LOADER_HIGH_WATERMARK_SECONDS || buffered_bytes >= LOADER_HIGH_WATERMARK_BYTES;
+            over_memory |= buffered_bytes >= LOADER_HIGH_WATERMARK_BYTES;
+        }
+
+        filling = !media_data->allPacketsRead && (any_starving || (filling && !all_satisfied && !over_memory));
+        if (clock_sec() - last_report_time >= LOADER_REPORT_INTERVAL_SECONDS) {
+            report_loader_status(media_data, player->displayCache->debug_info);
+            last_report_time = clock_sec();
         }
 
-        if (shouldFetch) {
-            fetch_next(media_data, 20);
+        if (filling) {
+            fetch_next(media_data, LOADER_BATCH_PACKETS);
+            if (media_data->allPacketsRead) {
+                report_loader_status(media_data, player->displayCache->debug_info);
+                player_state_notify(state);
+            }
+            continue;
         }
 
-        pthread_mutex_unlock(alterMutex);
-        sleep_for_ms(30);
+        media_data->loaderWaiting = 1;
+        player_state_wait_forever(state, seen_generation);
+        media_data->loaderWaiting = 0;
     }
 
+    report_loader_status(media_data, player->displayCache->debug_info);
     return NULL;
 }
 
+void wake_loader_if_starved(MediaData* media_data, MediaStream* stream, PlayerState* state) {
+    if (!media_data->loaderWaiting || media_data->allPacketsRead) {
+        return;
+    }
 
-void fetch_next(MediaData* media_data, int requestedPacketCount) {
-    AVPacket* readingPacket = av_packet_alloc();
-    int packetsRead = 0;
+    tracked_mutex_lock(&stream->lock);
+    const int starving = media_stream_buffered_seconds(stream) < LOADER_LOW_WATERMARK_SECONDS && media_stream_buffered_bytes(stream) < LOADER_LOW_WATERMARK_BYTES;
+    tracked_mutex_unlock(&stream->lock);
 
-    while (av_read_frame(media_data->formatContext, readingPacket) == 0) {
-        media_data->currentPacket++;
-        if (packetsRead >= requestedPacketCount) {
+    if (starving) {
+        media_data->loaderWaiting = 0;
+        player_state_notify(state);
+    }
+}
+
+void fetch_until(MediaData* media_data, MediaStream* stream, double target_time) {
+    while (!media_data->allPacketsRead) {
+        tracked_mutex_lock(&stream->lock);
+        const double buffered_end = media_stream_buffered_end_time(stream);
+        tracked_mutex_unlock(&stream->lock);
+        if (buffered_end >= target_time) {
             return;
         }
 
+        fetch_next(media_data, LOADER_BATCH_PACKETS);
+    }
+}
+
+int seek_media_data(MediaData* media_data, double target_time) {
+    const int64_t timestamp = (int64_t)(fmax(0.0, target_time) * AV_TIME_BASE);
+    tracked_mutex_lock(&media_data->demux_lock);
+    if (avformat_seek_file(media_data->formatContext, -1, INT64_MIN, timestamp, timestamp, 0) < 0) {
+        tracked_mutex_unlock(&media_data->demux_lock);
+        return 0;
+    }
+
+    media_data->seek_generation++;
+    for (int i = 0; i < media_data->nb_streams; i++) {
+        MediaStream* stream = media_data->media_streams[i];
+        tracked_mutex_lock(&stream->lock);
+        media_stream_clear_packets(stream);
+        stream->front_trimmed = timestamp > 0;
+        tracked_mutex_unlock(&stream->lock);
+    }
+    media_data->allPacketsRead = 0;
+    tracked_mutex_unlock(&media_data->demux_lock);
+    return 1;
+}
+
+void fetch_next(MediaData* media_data, int requestedPacketCount) {
+    AVPacket** staged_packets = (AVPacket**)malloc(sizeof(AVPacket*) * requestedPacketCount);
+    int* staged_streams = (int*)malloc(sizeof(int) * requestedPacketCount);
+    if (staged_packets == NULL || staged_streams == NULL) {
+        fprintf(stderr, "%s\n", "Could not allocate packet staging batch");
+        free(staged_packets);
+        free(staged_streams);
+        return;
+    }
+    int nb_staged = 0;
+
+    tracked_mutex_lock(&media_data->demux_lock);
+    const unsigned long seek_generation = media_data->seek_generation;
+    while (!media_data->allPacketsRead && nb_staged < requestedPacketCount) {
+        AVPacket* readingPacket = av_packet_alloc();
+        if (readingPacket == NULL) {
+            break;
+        }
+
+        const double read_start = clock_sec();
+        const int result = av_read_frame(media_data->formatContext, readingPacket);
+        read_latency_histogram_add(&media_data->read_latency, clock_sec() - read_start);
+        if (result < 0) {
+            av_packet_free(&readingPacket);
+            media_data->allPacketsRead = 1;
+            break;
+        }
+
+        media_data->currentPacket++;
+        int stream_index = -1;
         for (int i = 0; i < media_data->nb_streams; i++) {
             if (media_data->media_streams[i]->info->stream->index == readingPacket->stream_index) {
-                AVPacket* savedPacket = av_packet_alloc();
-                av_packet_ref(savedPacket, readingPacket);
-                selection_list_push_back(media_data->media_streams[i]->packets, savedPacket);
-                /* erase(); */
-                /* printw("Packet List For %s: %d", av_get_media_type_string(media_data->media_streams[i]->info->mediaType), selection_list_length(media_data->media_streams[i]->packets)); */
-                /* refresh(); */
+                stream_index = i;
                 break;
             }
         }
 
-        av_packet_unref(readingPacket);
+        if (stream_index == -1) {
+            av_packet_free(&readingPacket);
+            continue;
+        }
+
+        staged_packets[nb_staged] = readingPacket;
+        staged_streams[nb_staged] = stream_index;
+        nb_staged++;
+    }
+    tracked_mutex_unlock(&media_data->demux_lock);
+
+    for (int i = 0; i < media_data->nb_streams; i++) {
+        MediaStream* stream = media_data->media_streams[i];
+        int has_packets = 0;
+        for (int p = 0; p < nb_staged && !has_packets; p++) {
+            has_packets = staged_streams[p] == i;
+        }
+        if (!has_packets) {
+            continue;
+        }
+
+        tracked_mutex_lock(&stream->lock);
+        for (int p = 0; p < nb_staged; p++) {
+            if (staged_streams[p] == i) {
+                AVPacket* packet = staged_packets[p];
+                if (media_data->seek_generation != seek_generation || stream->predecoded) {
+                    av_packet_free(&packet);
+                    continue;
+                }
+
+                const int64_t packet_pts = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+                if (packet_pts != AV_NOPTS_VALUE && (stream->last_pts == AV_NOPTS_VALUE || packet_pts > stream->last_pts)) {
+                    stream->last_pts = packet_pts;
+                }
+                stream->total_bytes += packet->size;
+                selection_list_push_back(stream->packets, packet);
+            }
+        }
+        media_stream_trim(stream);
+        tracked_mutex_unlock(&stream->lock);
+    }
+
+    free(staged_packets);
+    free(staged_streams);
+}
+
+void read_latency_histogram_init(ReadLatencyHistogram* histogram) {
+    for (int i = 0; i < READ_LATENCY_HISTOGRAM_BUCKETS; i++) {
+        histogram->buckets[i] = 0;
+    }
+    histogram->nb_reads = 0;
+    histogram->total_time = 0.0;
+    histogram->max_time = 0.0;
+}
+
+void read_latency_histogram_add(ReadLatencyHistogram* histogram, double seconds) {
+    unsigned long microseconds = (unsigned long)(seconds * 1000000.0);
+    int bucket = 0;
+    while (microseconds > 1 && bucket < READ_LATENCY_HISTOGRAM_BUCKETS - 1) {
+        microseconds >>= 1;
+        bucket++;
     }
 
-    media_data->allPacketsRead = 1;
-    av_packet_free(&readingPacket);
+    histogram->buckets[bucket]++;
+    histogram->nb_reads++;
+    histogram->total_time += seconds;
+    histogram->max_time = seconds > histogram->max_time ? seconds : histogram->max_time;
+}
+
+void report_loader_status(MediaData* media_data, MediaDebugInfo* debug_info) {
+    char buffered_text[256 * media_data->nb_streams + 1];
+    int buffered_length = 0;
+    buffered_text[0] = '\0';
+    for (int i = 0; i < media_data->nb_streams; i++) {
+        MediaStream* stream = media_data->media_streams[i];
+        if (media_stream_is_discarded(stream)) {
+            continue;
+        }
+
+        tracked_mutex_lock(&stream->lock);
+        const double buffered_seconds = media_stream_buffered_seconds(stream);
+        const size_t buffered_bytes = media_stream_buffered_bytes(stream);
+        const int nb_packets = selection_list_length(stream->packets);
+        tracked_mutex_unlock(&stream->lock);
+
+        buffered_length += snprintf(buffered_text + buffered_length, sizeof(buffered_text) - buffered_length, "%s: %.2f s / %.2f MB buffered ahead, %d packets held\n",
+                av_get_media_type_string(stream->info->mediaType), buffered_seconds, buffered_bytes / (1024.0 * 1024.0), nb_packets);
+    }
+    add_debug_message(debug_info, debug_loader_source, debug_loader_type, "Buffered Media", "%s", buffered_text);
+
+    tracked_mutex_lock(&media_data->demux_lock);
+    ReadLatencyHistogram histogram = media_data->read_latency;
+    tracked_mutex_unlock(&media_data->demux_lock);
+    if (histogram.nb_reads == 0) {
+        return;
+    }
+
+    add_debug_message(debug_info, debug_loader_source, debug_loader_type, "Read Latency Summary", "av_read_frame: %lu reads, mean %.1f us, max %.1f us\n",
+            histogram.nb_reads, histogram.total_time / histogram.nb_reads * 1000000.0, histogram.max_time * 1000000.0);
+
+    char histogram_text[READ_LATENCY_HISTOGRAM_BUCKETS * 48];
+    int length = 0;
+    for (int i = 0; i < READ_LATENCY_HISTOGRAM_BUCKETS; i++) {
+        if (histogram.buckets[i] == 0) {
+            continue;
+        }
+
+        const int last_bucket = i == READ_LATENCY_HISTOGRAM_BUCKETS - 1;
+        const double share = (double)histogram.buckets[i] / histogram.nb_reads;
+        length += snprintf(histogram_text + length, sizeof(histogram_text) - length, "  %s %7lu us %8lu %5.1f%%\n",
+                last_bucket ? ">=" : "< ", last_bucket ? 1UL << i : 1UL << (i + 1), histogram.buckets[i], share * 100.0);
+    }
+    add_debug_message(debug_info, debug_loader_source, debug_loader_type, "Read Latency Histogram", "%s\n", histogram_text);
 }
@@ -1,21 +1,24 @@
 #include "color.h"
 #include "icons.h"
 #include "pixeldata.h"
+#include "ascii.h"
 #include <stdlib.h>
 #include <image.h>
 #include <video.h>
 #include <media.h>
 #include <info.h>
+#include <benchmark.h>
 
 #include <libavutil/log.h>
 #include <stdio.h>
 #include <string.h>
+#include <locale.h>
 #include <ncurses.h>
 
 typedef struct ProgramCommands ProgramCommands;
 
 typedef enum PriorityType {
-    PRIORITY_TYPE_HELP, PRIORITY_TYPE_INFORMATION, PRIORITY_TYPE_UNKNOWN
+    PRIORITY_TYPE_HELP, PRIORITY_TYPE_INFORMATION, PRIORITY_TYPE_BENCHMARK, PRIORITY_TYPE_UNKNOWN
 } PriorityType;
 
 typedef enum InputType {
@@ -31,6 +34,15 @@ struct ProgramCommands {
     InputType input;
     const char* file;
     PriorityType priority;
+    int period_size_frames;
+    int periods;
+    AudioPerformanceProfile audio_profile;
+    int predecode_limit_seconds;
+    int predecode_to_file;
+    RenderMethod render_method;
+    int dither;
+    GraphicsProtocol graphics_protocol;
+    int equalize;
 };
 
 const char* get_input_type_string(InputType type);
@@ -38,21 +50,36 @@ bool str_in_list(const char* search, const char** list, int list_len);
 bool is_valid_path(const char* path);
 void ncurses_init();
 int use_program(ProgramCommands* commands);
+void apply_player_settings(MediaPlayer* player, ProgramCommands* commands);
 
 const char* help_text = "     ASCII_VIDEO         \n"
       "  -h => help                   \n"
       "  -i <file> => show image file                   \n"
       "  -v <file> => play video file                   \n"
+      "  -a <file> => play audio only                   \n"
       "       --VIDEO CONTROLS--                   \n"
       "         RIGHT-ARROW -> Forward 10 seconds                   \n"
       "         LEFT-ARROW -> Backward 10 seconds                   \n"
       "         UP-ARROW -> Volume Up 5%                   \n"
       "         DOWN-ARROW -> Volume Down 5%                   \n"
       "         SPACEBAR -> Pause / Play                   \n"
-      "         c or C -> Switch between video view and Audio View                   \n"
+      "         c or C -> Cycle video, waveform and spectrum views                   \n"
       "         d or D -> Debug Mode                   \n"
       "       ------------------                   \n"
-      "  -info <file> => print file info                   \n";
+      "  --renderer <ascii|halfblock|braille|graphics|sixel|kitty> => video renderer, halfblock draws 1x2 and braille 2x4 pixels per cell,                   \n"
+      "         graphics probes the terminal for sixel or kitty image support (default ascii)                   \n"
+      "  --dither => ordered dithering for the braille renderer                   \n"
+      "  --ramp <standard|detailed|blocks|shades> => glyph ramp used by the ascii renderer (default standard)                   \n"
+      "  --equalize => adaptive contrast, spreads each frame's brightness over the whole glyph ramp                   \n"
+      "  -info <file> => print file info                   \n"
+      "  --benchmark => run audio sample conversion and image encoder microbenchmarks                   \n"
+      "       --AUDIO DEVICE OPTIONS (before <file>)--                   \n"
+      "         --period-size <frames> -> Audio device period size                   \n"
+      "         --periods <count> -> Number of audio device periods                   \n"
+      "         --predecode-limit <seconds> -> Fully decode audio of files up to this length, 0 disables (default 600)                   \n"
+      "         --predecode-file -> Keep fully decoded audio in a memory mapped temp file                   \n"
+      "         --low-latency -> Favor low audio latency (default)                   \n"
+      "         --conservative -> Favor fewer audio wakeups over latency                   \n";
 
 const int nb_input_flags = 6;
 const char* input_flags[6] = { "-v", "--video", "-i", "--image", "-a", "--audio" };
@@ -63,10 +90,21 @@ const char* format_flags[2] = { "-c", "--color" };
 const int nb_valid_flags = nb_input_flags + nb_format_flags;
 FormatType flag_to_format_type(const char* flag);
 
-const int nb_priority_flags = 4;
-const char* priority_flags[4] = { "-h", "--help", "-info", "--information" };
+const int nb_audio_value_flags = 3;
+const char* audio_value_flags[3] = { "--period-size", "--periods", "--predecode-limit" };
+void set_audio_value_flag(ProgramCommands* commands, const char* flag, const char* value);
+
+const int nb_audio_profile_flags = 2;
+const char* audio_profile_flags[2] = { "--low-latency", "--conservative" };
+AudioPerformanceProfile flag_to_audio_profile(const char* flag);
+
+const int nb_priority_flags = 5;
+const char* priority_flags[5] = { "-h", "--help", "-info", "--information", "--benchmark" };
 PriorityType flag_to_priority_type(const char* flag);
 
+RenderMethod string_to_render_method(const char* name);
+GraphicsProtocol string_to_graphics_protocol(const char* name);
+
 int main(int argc, char** argv)
 {
     if (argc == 1) {
@@ -74,14 +112,40 @@ int main(int argc, char** argv)
         return EXIT_SUCCESS;
     }
 
+  setlocale(LC_ALL, "");
   srand(time(NULL));
   av_log_set_level(AV_LOG_QUIET);
   /* av_log_set_level(AV_LOG_VERBOSE); */
+  init_glyph_ramps();
   init_icons();
 
-  ProgramCommands commands = { FORMAT_TYPE_GRAYSCALE, INPUT_TYPE_VIDEO, NULL, PRIORITY_TYPE_UNKNOWN };
+  ProgramCommands commands = { FORMAT_TYPE_GRAYSCALE, INPUT_TYPE_VIDEO, NULL, PRIORITY_TYPE_UNKNOWN, 0, 0, AUDIO_PROFILE_LOW_LATENCY, -1, 0, RENDER_METHOD_ASCII, 0, GRAPHICS_PROTOCOL_NONE, 0 };
   for (int i = 1; i < argc; i++) {
-      if (is_valid_path(argv[i])) {
+      if (str_in_list(argv[i], audio_value_flags, nb_audio_value_flags)) {
+          if (i + 1 < argc) {
+              set_audio_value_flag(&commands, argv[i], argv[i + 1]);
+              i++;
+          }
+      } else if (str_in_list(argv[i], audio_profile_flags, nb_audio_profile_flags)) {
+          commands.audio_profile = flag_to_audio_profile(argv[i]);
+      } else if (strcmp(argv[i], "--predecode-file") == 0) {
+          commands.predecode_to_file = 1;
+      } else if (strcmp(argv[i], "--dither") == 0) {
+          commands.dither = 1;
+      } else if (strcmp(argv[i], "--equalize") == 0) {
+          commands.equalize = 1;
+      } else if (strcmp(argv[i], "--ramp") == 0) {
+          if (i + 1 < argc) {
+              set_active_glyph_ramp(argv[i + 1]);
+              i++;
+          }
+      } else if (strcmp(argv[i], "--renderer") == 0) {
+          if (i + 1 < argc) {
+              commands.render_method = string_to_render_method(argv[i + 1]);
+              commands.graphics_protocol = string_to_graphics_protocol(argv[i + 1]);
+              i++;
+          }
+      } else if (is_valid_path(argv[i])) {
         commands.file = argv[i];
       } else if (str_in_list(argv[i], format_flags, nb_format_flags)) {
         commands.format = flag_to_format_type(argv[i]); 
@@ -106,6 +170,8 @@ int use_program(ProgramCommands* commands) {
     if (commands->priority == PRIORITY_TYPE_HELP) {
         printf("%s", help_text);
         return EXIT_SUCCESS;
+    } else if (commands->priority == PRIORITY_TYPE_BENCHMARK) {
+        return run_benchmarks();
     } else if (commands->priority == PRIORITY_TYPE_INFORMATION && commands->file != NULL) {
         return fileInfoProgram(commands->file);
     } else if (commands->file != NULL) {
@@ -113,24 +179,50 @@ int use_program(ProgramCommands* commands) {
             ncurses_init();
             return imageProgram(commands->file, has_colors() && commands->format == FORMAT_TYPE_COLORED ? true : false);
         } else if (commands->input == INPUT_TYPE_VIDEO) {
+            if (commands->render_method == RENDER_METHOD_GRAPHICS && commands->graphics_protocol == GRAPHICS_PROTOCOL_NONE) {
+                commands->graphics_protocol = probe_graphics_protocol();
+                commands->render_method = commands->graphics_protocol == GRAPHICS_PROTOCOL_NONE ? RENDER_METHOD_HALF_BLOCK : RENDER_METHOD_GRAPHICS;
+            }
             ncurses_init();
             MediaPlayer* player = media_player_alloc(commands->file);
-            player->displaySettings->use_colors = commands->format == FORMAT_TYPE_COLORED && player->displaySettings->can_use_colors;
             if (player != NULL) {
+                apply_player_settings(player, commands);
                 start_media_player(player);
                 media_player_free(player);
                 return EXIT_SUCCESS;
             }
             return EXIT_FAILURE;
         } else if (commands->input == INPUT_TYPE_AUDIO) {
-            printf("%s", "Audio Only Currently Unimplemented");
-            return EXIT_SUCCESS;
+            ncurses_init();
+            MediaPlayer* player = media_player_alloc(commands->file);
+            if (player != NULL) {
+                apply_player_settings(player, commands);
+                const int success = start_audio_player(player);
+                media_player_free(player);
+                return success ? EXIT_SUCCESS : EXIT_FAILURE;
+            }
+            return EXIT_FAILURE;
         }
     }
 
     return EXIT_FAILURE;
 }
 
+void apply_player_settings(MediaPlayer* player, ProgramCommands* commands) {
+    player->displaySettings->use_colors = commands->format == FORMAT_TYPE_COLORED && player->displaySettings->can_use_colors;
+    player->displaySettings->render_method = commands->render_method;
+    player->displaySettings->dither = commands->dither;
+    player->displaySettings->graphics_protocol = commands->graphics_protocol;
+    player->displaySettings->equalize = commands->equalize;
+    player->audioSettings->period_size_frames = commands->period_size_frames;
+    player->audioSettings->periods = commands->periods;
+    player->audioSettings->profile = commands->audio_profile;
+    player->audioSettings->predecode_to_file = commands->predecode_to_file;
+    if (commands->predecode_limit_seconds >= 0) {
+        player->audioSettings->predecode_max_seconds = commands->predecode_limit_seconds;
+    }
+}
+
 bool str_in_list(const char* search, const char** list, int list_len) {
     for (int i = 0; i < list_len; i++) {
         if (strcmp(list[i], search) == 0) {
@@ -191,6 +283,50 @@ PriorityType flag_to_priority_type(const char* flag) {
         return PRIORITY_TYPE_HELP;
     } else if (strcmp(flag, "-info") == 0 || strcmp(flag, "--information") == 0) {
         return PRIORITY_TYPE_INFORMATION;
+    } else if (strcmp(flag, "--benchmark") == 0) {
+        return PRIORITY_TYPE_BENCHMARK;
     }
     return PRIORITY_TYPE_UNKNOWN;
 }
+
+RenderMethod string_to_render_method(const char* name) {
+    if (strcmp(name, "halfblock") == 0 || strcmp(name, "half-block") == 0) {
+        return RENDER_METHOD_HALF_BLOCK;
+    } else if (strcmp(name, "braille") == 0) {
+        return RENDER_METHOD_BRAILLE;
+    } else if (strcmp(name, "graphics") == 0 || strcmp(name, "sixel") == 0 || strcmp(name, "kitty") == 0) {
+        return RENDER_METHOD_GRAPHICS;
+    }
+    return RENDER_METHOD_ASCII;
+}
+
+GraphicsProtocol string_to_graphics_protocol(const char* name) {
+    if (strcmp(name, "sixel") == 0) {
+        return GRAPHICS_PROTOCOL_SIXEL;
+    } else if (strcmp(name, "kitty") == 0) {
+        return GRAPHICS_PROTOCOL_KITTY;
+    }
+    return GRAPHICS_PROTOCOL_NONE;
+}
+
+void set_audio_value_flag(ProgramCommands* commands, const char* flag, const char* value) {
+    const int number = atoi(value);
+    if (number < 0) {
+        return;
+    }
+
+    if (strcmp(flag, "--period-size") == 0) {
+        commands->period_size_frames = number;
+    } else if (strcmp(flag, "--periods") == 0) {
+        commands->periods = number;
+    } else if (strcmp(flag, "--predecode-limit") == 0) {
+        commands->predecode_limit_seconds = number;
+    }
+}
+
+AudioPerformanceProfile flag_to_audio_profile(const char* flag) {
+    if (strcmp(flag, "--conservative") == 0) {
+        return AUDIO_PROFILE_CONSERVATIVE;
+    }
+    return AUDIO_PROFILE_LOW_LATENCY;
+}
@@ -5,7 +5,9 @@
 #include <stdint.h>
 #include <media.h>
 #include <stdarg.h>
+#include <math.h>
 #include <wmath.h>
+#include <macros.h>
 
 void video_symbol_stack_push(VideoSymbolStack* stack, VideoSymbol *symbol) {
     if (stack->top < VIDEO_SYMBOL_BUFFER_SIZE - 1) {
@@ -64,7 +66,133 @@ int has_media_stream(MediaData* media_data, enum AVMediaType media_type) {
 }
 
 double get_playback_current_time(Playback* playback) {
-    return clock_sec() - playback->start_time - playback->paused_time + playback->skipped_time; 
+    tracked_mutex_lock(&playback->lock);
+    const double current_time = (playback->playing ? clock_sec() : playback->paused_at) - playback->start_time - playback->paused_time + playback->skipped_time; 
+    tracked_mutex_unlock(&playback->lock);
+    return current_time;
+}
+
+double media_stream_buffered_seconds(MediaStream* stream) {
+    AVPacket* current = (AVPacket*)selection_list_get(stream->packets);
+    if (current == NULL || stream->last_pts == AV_NOPTS_VALUE) {
+        return 0.0;
+    }
+
+    const int64_t current_pts = current->pts != AV_NOPTS_VALUE ? current->pts : current->dts;
+    if (current_pts == AV_NOPTS_VALUE) {
+        return 0.0;
+    }
+    return fmax(0.0, (stream->last_pts - current_pts) * stream->timeBase);
+}
+
+size_t media_stream_buffered_bytes(MediaStream* stream) {
+    const int length = selection_list_length(stream->packets);
+    if (length == 0) {
+        return 0;
+    }
+
+    const int packets_ahead = length - selection_list_index(stream->packets) - 1;
+    return (size_t)((double)stream->total_bytes / length * packets_ahead);
+}
+
+double media_stream_buffered_end_time(MediaStream* stream) {
+    return stream->last_pts == AV_NOPTS_VALUE ? 0.0 : stream->last_pts * stream->timeBase;
+}
+
+double media_stream_buffered_start_time(MediaStream* stream) {
+    AVPacket* first = (AVPacket*)selection_list_peek_front(stream->packets);
+    if (first == NULL) {
+        return media_stream_buffered_end_time(stream);
+    }
+
+    const int64_t first_pts = first->pts != AV_NOPTS_VALUE ? first->pts : first->dts;
+    return first_pts == AV_NOPTS_VALUE ? 0.0 : first_pts * stream->timeBase;
+}
+
+void media_stream_trim(MediaStream* stream) {
+    AVPacket* current = (AVPacket*)selection_list_get(stream->packets);
+    if (current == NULL) {
+        return;
+    }
+
+    const int64_t current_pts = current->pts != AV_NOPTS_VALUE ? current->pts : current->dts;
+    const int64_t keep_pts = current_pts != AV_NOPTS_VALUE ? current_pts - (int64_t)(LOADER_KEEP_BEHIND_SECONDS / stream->timeBase) : INT64_MIN;
+    while (selection_list_index(stream->packets) > 0) {
+        AVPacket* first = (AVPacket*)selection_list_peek_front(stream->packets);
+        const int64_t first_pts = first->pts != AV_NOPTS_VALUE ? first->pts : first->dts;
+        const size_t behind_bytes = (size_t)((double)stream->total_bytes / selection_list_length(stream->packets) * selection_list_index(stream->packets));
+        if (first_pts != AV_NOPTS_VALUE && first_pts >= keep_pts && behind_bytes <= LOADER_KEEP_BEHIND_BYTES) {
+            break;
+        }
+
+        selection_list_pop_front(stream->packets);
+        stream->total_bytes -= first->size;
+        stream->front_trimmed = 1;
+        av_packet_free(&first);
+    }
+}
+
+void media_stream_clear_packets(MediaStream* stream) {
+    while (selection_list_length(stream->packets) > 0) {
+        AVPacket* packet = (AVPacket*)selection_list_pop_front(stream->packets);
+        av_packet_free(&packet);
+    }
+    stream->total_bytes = 0;
+    stream->last_pts = AV_NOPTS_VALUE;
+}
+
+int media_stream_is_discarded(MediaStream* stream) {
+    return stream->disabled || stream->predecoded;
+}
+
+void playback_skip_time(Playback* playback, double seconds) {
+    tracked_mutex_lock(&playback->lock);
+    playback->skipped_time += seconds;
+    tracked_mutex_unlock(&playback->lock);
+}
+
+void playback_apply_playing(Playback* playback, int playing) {
+    if (playing && !playback->playing) {
+        playback->paused_time += clock_sec() - playback->paused_at;
+    } else if (!playing && playback->playing) {
+        playback->paused_at = clock_sec();
+    }
+    playback->playing = playing;
+}
+
+void playback_set_playing(Playback* playback, int playing) {
+    tracked_mutex_lock(&playback->lock);
+    playback_apply_playing(playback, playing);
+    tracked_mutex_unlock(&playback->lock);
+}
+
+void playback_toggle_playing(Playback* playback) {
+    tracked_mutex_lock(&playback->lock);
+    playback_apply_playing(playback, !playback->playing);
+    tracked_mutex_unlock(&playback->lock);
+}
+
+/* Locks are listed in the order they must be acquired when nested */
+int get_media_player_locks(MediaPlayer* player, TrackedMutex** locks, int max_locks) {
+    MediaData* media_data = player->timeline->mediaData;
+    TrackedMutex* all_locks[MAX_TRACKED_LOCKS];
+    int nb_locks = 0;
+
+    all_locks[nb_locks++] = &media_data->demux_lock;
+    for (int i = 0; i < media_data->nb_streams && nb_locks < MAX_TRACKED_LOCKS - 5; i++) {
+        all_locks[nb_locks++] = &media_data->media_streams[i]->lock;
+    }
+    all_locks[nb_locks++] = &player->displayCache->lock;
+    all_locks[nb_locks++] = &player->displayCache->audio_stream->lock;
+    all_locks[nb_locks++] = &player->displayCache->audio_stream->envelope_lock;
+    all_locks[nb_locks++] = &player->timeline->playback->lock;
+    all_locks[nb_locks++] = &player->displayCache->debug_info->lock;
+
+    nb_locks = i32min(nb_locks, max_locks);
+    for (int i = 0; i < nb_locks; i++) {
+        locks[i] = all_locks[i];
+    }
+    return nb_locks;
 }
 
 
@@ -167,15 +295,31 @@ void move_frame_list_to_pts(SelectionList* frames, int64_t targetPTS) {
 }
 
 double audio_stream_time(AudioStream* stream) {
-    return stream->start_time + ((double)stream->playhead / stream->sample_rate);
+    return stream->start_time + ((double)(stream->trimmed_samples + stream->playhead) + stream->read_phase) / stream->sample_rate;
 }
 
 double audio_stream_set_time(AudioStream* stream, double time) {
     if (stream->nb_samples == 0) return 0.0;
-    stream->playhead = (size_t)(fmin(stream->nb_samples - 1, fmax( 0.0, (time - stream->start_time) * stream->sample_rate  )  )  );
+    stream->playhead = (size_t)(fmin(stream->nb_samples - 1, fmax( 0.0, (time - stream->start_time) * stream->sample_rate - (double)stream->trimmed_samples )  )  );
+    stream->read_phase = 0.0;
     return stream->playhead;
 }
 
+double audio_stream_buffered_seconds(AudioStream* stream) {
+    if (stream->sample_rate == 0 || stream->playhead >= stream->nb_samples) {
+        return 0.0;
+    }
+    return (double)(stream->nb_samples - stream->playhead) / stream->sample_rate;
+}
+
+size_t audio_stream_start_sample(AudioStream* stream) {
+    return (stream->start_time > 0.0 ? (size_t)(stream->start_time * stream->sample_rate + 0.5) : 0) + stream->trimmed_samples;
+}
+
+double audio_stream_buffered_start_time(AudioStream* stream) {
+    return stream->start_time + (double)stream->trimmed_samples / stream->sample_rate;
+}
+
 double audio_stream_end_time(AudioStream *stream) {
-    return stream->start_time + ((double)stream->nb_samples / stream->sample_rate);
+    return stream->start_time + ((double)(stream->trimmed_samples + stream->nb_samples) / stream->sample_rate);
 }
@@ -0,0 +1,149 @@
+#include <predecode.h>
+#include <audio.h>
+#include <boiler.h>
+#include <debug.h>
+#include <macros.h>
+#include <wtime.h>
+#include <stdio.h>
+
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+
+const char* debug_predecode_source = "audio";
+const char* debug_predecode_type = "debug";
+
+int predecode_audio_file(MediaPlayer* player, AudioStream* target);
+
+int should_predecode_audio(MediaPlayer* player) {
+    const double limit = player->audioSettings->predecode_max_seconds;
+    const double duration = player->timeline->mediaData->duration;
+    return limit > 0.0 && duration > 0.0 && duration <= limit;
+}
+
+int start_audio_predecode(AudioPredecodeJob* job, MediaPlayer* player) {
+    job->player = player;
+    job->started = pthread_create(&job->thread, NULL, audio_predecode_thread, (void*)job) == 0;
+    if (!job->started) {
+        fprintf(stderr, "%s\n", "Failed to create audio predecode thread");
+    }
+    return job->started;
+}
+
+void join_audio_predecode(AudioPredecodeJob* job) {
+    if (job->started) {
+        pthread_join(job->thread, NULL);
+        job->started = 0;
+    }
+}
+
+void* audio_predecode_thread(void* args) {
+    AudioPredecodeJob* job = (AudioPredecodeJob*)args;
+    MediaPlayer* player = job->player;
+    MediaDebugInfo* debug_info = player->displayCache->debug_info;
+    const double start_time = clock_sec();
+
+    AudioStream* predecoded = audio_stream_alloc();
+    if (predecoded == NULL) {
+        add_debug_message(debug_info, debug_predecode_source, debug_predecode_type, "Audio Predecode", "Could not allocate predecode buffer\n");
+        return NULL;
+    }
+
+    if (!predecode_audio_file(player, predecoded)) {
+        audio_stream_free(predecoded);
+        return NULL;
+    }
+
+    MediaData* media_data = player->timeline->mediaData;
+    MediaStream* audio_media_stream = get_media_stream(media_data, AVMEDIA_TYPE_AUDIO);
+    AudioStream* audioStream = player->displayCache->audio_stream;
+    if (audio_media_stream != NULL) {
+        tracked_mutex_lock(&media_data->demux_lock);
+        audio_media_stream->info->stream->discard = AVDISCARD_ALL;
+        tracked_mutex_lock(&audio_media_stream->lock);
+        audio_media_stream->predecoded = 1;
+    }
+    tracked_mutex_lock(&audioStream->lock);
+    audio_stream_adopt(audioStream, predecoded);
+    const double seconds = (double)audioStream->nb_samples / audioStream->sample_rate;
+    const double megabytes = (double)audioStream->nb_samples * audioStream->nb_channels / (1024.0 * 1024.0);
+    const int mapped = audioStream->backing_fd >= 0;
+    tracked_mutex_unlock(&audioStream->lock);
+    if (audio_media_stream != NULL) {
+        media_stream_clear_packets(audio_media_stream);
+        tracked_mutex_unlock(&audio_media_stream->lock);
+        tracked_mutex_unlock(&media_data->demux_lock);
+    }
+    audio_stream_free(predecoded);
+
+    add_debug_message(debug_info, debug_predecode_source, debug_predecode_type, "Audio Predecode", "Predecoded %.1f s of audio (%.1f MB, %s) in %.2f s\n",
+            seconds, megabytes, mapped ? "temp file" : "memory", clock_sec() - start_time);
+    player_state_notify(player->state);
+    return NULL;
+}
+
+int predecode_audio_file(MediaPlayer* player, AudioStream* target) {
+    MediaDebugInfo* debug_info = player->displayCache->debug_info;
+    int result;
+    AVFormatContext* formatContext = open_format_context(player->fileName, &result);
+    if (formatContext == NULL) {
+        add_debug_message(debug_info, debug_predecode_source, debug_predecode_type, "Audio Predecode", "Could not open %s for predecoding\n", player->fileName);
+        return 0;
+    }
+
+    const enum AVMediaType mediaTypes[1] = { AVMEDIA_TYPE_AUDIO };
+    int nb_streams;
+    StreamData** streamDatas = alloc_stream_datas(formatContext, mediaTypes, 1, &nb_streams);
+    if (streamDatas == NULL || nb_streams == 0) {
+        free(streamDatas);
+        avformat_close_input(&formatContext);
+        return 0;
+    }
+
+    StreamData* audioData = streamDatas[0];
+    AVCodecContext* codecContext = audioData->codecContext;
+    for (unsigned int i = 0; i < formatContext->nb_streams; i++) {
+        if (formatContext->streams[i] != audioData->stream) {
+            formatContext->streams[i]->discard = AVDISCARD_ALL;
+        }
+    }
+
+    AudioResampler* resampler = NULL;
+    if (codecContext->sample_fmt != AV_SAMPLE_FMT_U8) {
+        resampler = get_audio_resampler(&result, &codecContext->ch_layout, AV_SAMPLE_FMT_U8, codecContext->sample_rate,
+                &codecContext->ch_layout, codecContext->sample_fmt, codecContext->sample_rate);
+    }
+
+    const int nb_channels = codecContext->ch_layout.nb_channels;
+    const size_t expected_samples = (player->timeline->mediaData->duration + 1.0) * codecContext->sample_rate;
+    AVPacket* packet = av_packet_alloc();
+    AVFrame* decodeFrame = av_frame_alloc();
+    int success = packet != NULL && decodeFrame != NULL && (codecContext->sample_fmt == AV_SAMPLE_FMT_U8 || resampler != NULL)
+        && audio_stream_init(target, nb_channels, codecContext->sample_rate, codecContext->sample_rate)
+        && (!player->audioSettings->predecode_to_file || audio_stream_map_temp_file(target))
+        && audio_stream_reserve(target, expected_samples);
+
+    if (success) {
+        if (audioData->stream->start_time != AV_NOPTS_VALUE) {
+            target->start_time = audioData->stream->start_time * av_q2d(audioData->stream->time_base);
+        }
+
+        SwrContext* swrContext = resampler != NULL ? resampler->context : NULL;
+        while (player->inUse && av_read_frame(formatContext, packet) >= 0) {
+            if (packet->stream_index == audioData->stream->index) {
+                decode_audio_packet_into_stream(codecContext, swrContext, packet, decodeFrame, target);
+            }
+            av_packet_unref(packet);
+        }
+        decode_audio_packet_into_stream(codecContext, swrContext, NULL, decodeFrame, target);
+        success = player->inUse && target->nb_samples > 0;
+    }
+
+    av_packet_free(&packet);
+    av_frame_free(&decodeFrame);
+    if (resampler != NULL) {
+        free_audio_resampler(resampler);
+    }
+    stream_datas_free(streamDatas, nb_streams);
+    avformat_close_input(&formatContext);
+    return success;
+}
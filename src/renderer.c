@@ -19,12 +19,17 @@
 #include <threads.h>
 #include <wmath.h>
 #include <wtime.h>
+#include <subcell.h>
 
 #include <ncurses.h>
 #include <curses_helpers.h>
 #define KEY_ESCAPE 27
 
 void render_playbar(MediaPlayer* player, GuiData gui_data);
+void render_audio_meter(MediaPlayer* player, AudioMeter* meter, int y);
+int format_time(char* buffer, int buf_size, double time_in_seconds);
+void hide_graphics_output(MediaPlayer* player);
+void reconfigure_display(MediaPlayer* player, GuiData gui_data);
 
 void get_index_display_color(int index, int length, rgb output) {
     const double step = (255.0 / 2.0) / length;
@@ -38,23 +43,31 @@ int digit_to_int(char num) {
     return num - 48;
 }
 
-void render_loop(MediaPlayer* player, pthread_mutex_t* alterMutex) {
+void render_loop(MediaPlayer* player) {
     WINDOW* inputWindow = newwin(0, 0, 1, 1);
     MEVENT mouse_event;
     mousemask(BUTTON1_PRESSED, NULL);
 
-    nodelay(inputWindow, true);
     keypad(inputWindow, true);
     double jump_time_requested = 0;
-    GuiData gui_data = { DISPLAY_MODE_VIDEO, { 0, 1 }, { player->displaySettings->use_colors, 1 }, 0 };
+    GuiData gui_data = { DISPLAY_MODE_VIDEO, { 0, 1, AUDIO_VIEW_DEFAULT_SAMPLES }, { player->displaySettings->use_colors, 1 }, 0 };
+    Playback* playback = player->timeline->playback;
+    PlayerState* state = player->state;
+    reconfigure_display(player, gui_data);
 
     while (player->inUse) {
-        pthread_mutex_lock(alterMutex);
+        if (playback->playing) {
+            wtimeout(inputWindow, RENDER_PLAYING_INPUT_TIMEOUT_MILLISECONDS);
+        } else if (player->displayCache->symbol_stack->top >= 0 || jump_time_requested != 0) {
+            wtimeout(inputWindow, RENDER_SYMBOL_INPUT_TIMEOUT_MILLISECONDS);
+        } else {
+            wtimeout(inputWindow, RENDER_PAUSED_INPUT_TIMEOUT_MILLISECONDS);
+        }
+
         int ch = wgetch(inputWindow);
-        Playback* playback = player->timeline->playback;
+        player_state_count_wakeup(state, PLAYER_THREAD_RENDER);
 
         if (!player->inUse) {
-            pthread_mutex_unlock(alterMutex);
             break;
         }
 
@@ -62,21 +75,27 @@ void render_loop(MediaPlayer* player, pthread_mutex_t* alterMutex) {
             double targetTime = get_playback_current_time(playback) + jump_time_requested;
             if (targetTime >= player->timeline->mediaData->duration) {
                 player->inUse = 0;
-                pthread_mutex_unlock(alterMutex);
+                player_state_notify(state);
                 break;
             }
 
             jump_to_time(player->timeline, targetTime);
             video_symbol_stack_push(player->displayCache->symbol_stack, jump_time_requested < 0 ? get_video_symbol(BACKWARD_ICON) : get_video_symbol(FORWARD_ICON));
             jump_time_requested = 0;
+            player_state_notify(state);
         }
 
         if (ch == ' ') {
-            playback->playing = !playback->playing;
+            playback_toggle_playing(playback);
+            player_state_notify(state);
         } else if (ch == 'd' || ch == 'D') {
             gui_data.show_debug = !gui_data.show_debug;
         } else if (ch == 'c' || ch == 'C') {
             gui_data.mode = get_next_display_mode(gui_data.mode);
+            tracked_mutex_lock(&player->displayCache->audio_stream->lock);
+            player->displayCache->spectrum->enabled = gui_data.mode == DISPLAY_MODE_SPECTRUM;
+            tracked_mutex_unlock(&player->displayCache->audio_stream->lock);
+            player_state_notify(state);
         } else if (ch == KEY_LEFT) {
             jump_time_requested -= TIME_CHANGE_AMOUNT;
         } else if (ch == KEY_RIGHT) {
@@ -96,22 +115,37 @@ void render_loop(MediaPlayer* player, pthread_mutex_t* alterMutex) {
             }
 
         } else if (ch == KEY_UP) {
+            tracked_mutex_lock(&playback->lock);
             playback->volume = fmin(1.0, playback->volume + VOLUME_CHANGE_AMOUNT);
+            tracked_mutex_unlock(&playback->lock);
             video_symbol_stack_push(player->displayCache->symbol_stack,get_symbol_from_volume(playback->volume));
         } else if (ch == KEY_DOWN) {
-            playback->volume = fmin(1.0, playback->volume - VOLUME_CHANGE_AMOUNT);
+            tracked_mutex_lock(&playback->lock);
+            playback->volume = fmax(0.0, playback->volume - VOLUME_CHANGE_AMOUNT);
+            tracked_mutex_unlock(&playback->lock);
             video_symbol_stack_push(player->displayCache->symbol_stack,get_symbol_from_volume(playback->volume));
         } else if (ch == 'n' || ch == 'N') {
+            tracked_mutex_lock(&playback->lock);
             playback->speed = fmin(5.0, playback->speed + PLAYBACK_SPEED_CHANGE_INTERVAL);
+            tracked_mutex_unlock(&playback->lock);
         } else if (ch == 'm' || ch == 'M') {
+            tracked_mutex_lock(&playback->lock);
             playback->speed = fmax(0.25, playback->speed - PLAYBACK_SPEED_CHANGE_INTERVAL);
+            tracked_mutex_unlock(&playback->lock);
         } else if (ch == 'x' || ch == 'X' || ch == KEY_ESCAPE) {
             player->inUse = player->inUse == 1 ? 0 : 1;
+            player_state_notify(state);
+        } else if ((ch == '+' || ch == '=') && gui_data.mode == DISPLAY_MODE_AUDIO) {
+            gui_data.audio.shown_samples = gui_data.audio.shown_samples / 2 >= (size_t)COLS ? gui_data.audio.shown_samples / 2 : gui_data.audio.shown_samples;
+        } else if (ch == '-' && gui_data.mode == DISPLAY_MODE_AUDIO) {
+            gui_data.audio.shown_samples = gui_data.audio.shown_samples * 2 <= AUDIO_VIEW_MAX_SAMPLES ? gui_data.audio.shown_samples * 2 : gui_data.audio.shown_samples;
         } else if (ch == 'f' || ch == 'F') {
             gui_data.video.fullscreen = gui_data.video.fullscreen == 1 ? 0 : 1;
+            reconfigure_display(player, gui_data);
         } else if (ch == KEY_RESIZE) {
             endwin();
             refresh();
+            reconfigure_display(player, gui_data);
         } else if (ch >= '0' && ch <= '9') {
             int digit = digit_to_int(ch);
             if (gui_data.mode == DISPLAY_MODE_VIDEO) {
@@ -137,7 +171,8 @@ void render_loop(MediaPlayer* player, pthread_mutex_t* alterMutex) {
                             jump_time_requested = time - get_playback_current_time(player->timeline->playback);
                         }
                     } else {
-                        playback->playing = !playback->playing;
+                        playback_toggle_playing(playback);
+                        player_state_notify(state);
                     }
                 }
             }
@@ -147,96 +182,181 @@ void render_loop(MediaPlayer* player, pthread_mutex_t* alterMutex) {
         render_screen(player, gui_data);
         if (get_playback_current_time(player->timeline->playback) > player->timeline->mediaData->duration) {
             player->inUse = 0;
+            player_state_notify(state);
         }
 
-        pthread_mutex_unlock(alterMutex);
         refresh();
-        sleep_for_ms(5);
+        frame_arena_reset(player->displayCache->frame_arena);
     }
 
+    hide_graphics_output(player);
     delwin(inputWindow);
 }
 
-void render_screen(MediaPlayer* player, GuiData gui_data) {
-    if (gui_data.show_debug) {
-        if (gui_data.mode == DISPLAY_MODE_VIDEO) {
-            render_video_debug(player, gui_data);
-        } else if (gui_data.mode == DISPLAY_MODE_AUDIO) {
-            render_audio_debug(player, gui_data);
+void render_audio_status(MediaPlayer* player);
+
+void audio_status_loop(MediaPlayer* player) {
+    Playback* playback = player->timeline->playback;
+    PlayerState* state = player->state;
+    const double duration = player->timeline->mediaData->duration;
+    timeout(AUDIO_STATUS_REFRESH_MILLISECONDS);
+
+    while (player->inUse) {
+        int ch = getch();
+        player_state_count_wakeup(state, PLAYER_THREAD_RENDER);
+
+        if (!player->inUse) {
+            break;
         }
-    } else {
-        if (gui_data.mode == DISPLAY_MODE_VIDEO) {
-            if (player->displayCache->image != NULL && player->displayCache->last_rendered_image != NULL) {
-                if (!pixel_data_equals(player->displayCache->image, player->displayCache->last_rendered_image)) {
-                    render_movie_screen(player, gui_data);
-                }
+
+        if (ch == ' ') {
+            playback_toggle_playing(playback);
+            player_state_notify(state);
+        } else if (ch == KEY_LEFT || ch == KEY_RIGHT) {
+            const double targetTime = get_playback_current_time(playback) + (ch == KEY_LEFT ? -TIME_CHANGE_AMOUNT : TIME_CHANGE_AMOUNT);
+            if (targetTime >= duration) {
+                player->inUse = 0;
+                player_state_notify(state);
+                break;
             }
-        } else if (gui_data.mode == DISPLAY_MODE_AUDIO) {
-            render_audio_screen(player, gui_data);
+
+            jump_to_time(player->timeline, targetTime);
+            player_state_notify(state);
+        } else if (ch == KEY_UP) {
+            tracked_mutex_lock(&playback->lock);
+            playback->volume = fmin(1.0, playback->volume + VOLUME_CHANGE_AMOUNT);
+            tracked_mutex_unlock(&playback->lock);
+        } else if (ch == KEY_DOWN) {
+            tracked_mutex_lock(&playback->lock);
+            playback->volume = fmax(0.0, playback->volume - VOLUME_CHANGE_AMOUNT);
+            tracked_mutex_unlock(&playback->lock);
+        } else if (ch == 'n' || ch == 'N') {
+            tracked_mutex_lock(&playback->lock);
+            playback->speed = fmin(5.0, playback->speed + PLAYBACK_SPEED_CHANGE_INTERVAL);
+            tracked_mutex_unlock(&playback->lock);
+        } else if (ch == 'm' || ch == 'M') {
+            tracked_mutex_lock(&playback->lock);
+            playback->speed = fmax(0.25, playback->speed - PLAYBACK_SPEED_CHANGE_INTERVAL);
+            tracked_mutex_unlock(&playback->lock);
+        } else if (ch == 'x' || ch == 'X' || ch == KEY_ESCAPE) {
+            player->inUse = 0;
+            player_state_notify(state);
+            break;
+        } else if (ch == KEY_RESIZE) {
+            endwin();
+            refresh();
         }
-    }
 
+        render_audio_status(player);
+        if (get_playback_current_time(playback) > duration) {
+            player->inUse = 0;
+            player_state_notify(state);
+        }
 
-    if (player->displayCache->last_rendered_image != NULL) {
-        pixel_data_free(player->displayCache->last_rendered_image);
-    }
-    if (player->displayCache->image != NULL) {
-        player->displayCache->last_rendered_image = copy_pixel_data(player->displayCache->image);
+        refresh();
     }
 }
 
-void collapse_wave(float* output, int output_sample_count, float* input, int input_sample_count, int nb_channels) {
-    float step = (float)input_sample_count / output_sample_count;
-    float current_step = 0.0f;
-    for (int i = 0; i < output_sample_count; i++) {
-    float average = 0.0f;
-        for (int ichannel = 0; ichannel < nb_channels; ichannel++) {
-           average = 0.0;
-           for (int origi = (int)(current_step); origi < (int)(current_step + step); origi++) {
-               average += input[origi * nb_channels + ichannel];
-           }
-           average /= step;
-           output[i * nb_channels + ichannel] = average;
+void render_audio_status(MediaPlayer* player) {
+    Playback* playback = player->timeline->playback;
+    AudioStream* audio_stream = player->displayCache->audio_stream;
+    const double duration = player->timeline->mediaData->duration;
+    const double time = fmin(get_playback_current_time(playback), duration);
+
+    tracked_mutex_lock(&audio_stream->lock);
+    AudioMeter meter = player->displayCache->audio_meter;
+    const int nb_channels = audio_stream->nb_channels;
+    const int sample_rate = audio_stream->sample_rate;
+    tracked_mutex_unlock(&audio_stream->lock);
+
+    erase();
+    char playTime[15], durationTime[15];
+    format_time(playTime, 15, time);
+    format_time(durationTime, 15, duration);
+    mvprintw(0, 0, "%s", player->fileName);
+    mvprintw(1, 0, "%d channels, %d Hz", nb_channels, sample_rate);
+    mvprintw(3, 0, "%-7s %s/%s  x%.2f", playback->playing ? "Playing" : "Paused", playTime, durationTime, playback->speed);
+
+    const int bar_width = COLS - 2;
+    if (bar_width > 0) {
+        const int filled = duration > 0.0 ? bar_width * (time / duration) : 0;
+        mvaddch(4, 0, '[');
+        for (int i = 0; i < bar_width; i++) {
+            addch(i < filled ? '*' : '-');
         }
-        current_step += step;
+        addch(']');
     }
+
+    render_audio_meter(player, &meter, 6);
+    mvprintw(8, 0, "SPACE pause | LEFT/RIGHT seek %ds | UP/DOWN volume | N/M speed | X quit", TIME_CHANGE_AMOUNT);
 }
 
-void expand_wave(float* output, int output_sample_count, float* input, int input_sample_count, int nb_channels) {
-    float stretch = (float)output_sample_count / input_sample_count;
-    float current_step = 0.0f;
-    for (int i = 0; i < output_sample_count; i++) {
-        for (int ch = 0; ch < nb_channels; ch++) {
-            float current_input = input[(int)(current_step * nb_channels) + ch];
-            float last_input = current_step > stretch ? input[(int)((current_step - stretch) * nb_channels) + ch] : 0.0f;
-            float step = (current_input - last_input) / stretch;
-            float current_sample_value = last_input;
-            for (int orig = (int)current_step; orig < (int)(current_step + stretch); orig++) {
-                output[(i + orig) * nb_channels + ch] = current_sample_value;
-                current_sample_value += step;
+void render_screen(MediaPlayer* player, GuiData gui_data) {
+    MediaDisplayCache* cache = player->displayCache;
+    tracked_mutex_lock(&cache->lock);
+    const int image_changed = cache->image != NULL && (cache->last_rendered_image == NULL || !pixel_data_equals(cache->image, cache->last_rendered_image));
+    if (image_changed && (cache->last_rendered_image == NULL || !copy_pixel_data_into(cache->last_rendered_image, cache->image))) {
+        if (cache->last_rendered_image != NULL) {
+            pixel_data_free(cache->last_rendered_image);
+        }
+        cache->last_rendered_image = copy_pixel_data(cache->image);
+    }
+    tracked_mutex_unlock(&cache->lock);
+
+    FrameArena* arena = cache->frame_arena;
+    frame_arena_bind(arena);
+
+    if (gui_data.show_debug || gui_data.mode != DISPLAY_MODE_VIDEO) {
+        hide_graphics_output(player);
+    }
+
+    if (gui_data.show_debug) {
+        if (gui_data.mode == DISPLAY_MODE_VIDEO) {
+            render_video_debug(player, gui_data);
+        } else if (gui_data.mode == DISPLAY_MODE_AUDIO || gui_data.mode == DISPLAY_MODE_SPECTRUM) {
+            render_audio_debug(player, gui_data);
+        }
+    } else {
+        if (gui_data.mode == DISPLAY_MODE_VIDEO) {
+            if (image_changed) {
+                render_movie_screen(player, gui_data);
             }
+        } else if (gui_data.mode == DISPLAY_MODE_AUDIO) {
+            render_audio_screen(player, gui_data);
+        } else if (gui_data.mode == DISPLAY_MODE_SPECTRUM) {
+            render_spectrum_screen(player);
         }
-        current_step += stretch;
     }
+    frame_arena_bind(NULL);
 }
 
-void normalize_wave(float* to_normalize, int nb_samples, int nb_channels) {
-    float maxes[nb_channels];
-    for (int i = 0; i < nb_channels; i++) {
-        maxes[i] = -(float)INT32_MAX;
+void get_waveform_columns(AudioStream* audio_stream, int channel, size_t start_sample, size_t samples_per_column, int nb_columns, WaveformColumn* output) {
+    tracked_mutex_lock(&audio_stream->envelope_lock);
+    const int from_envelope = audio_stream->envelope != NULL && waveform_envelope_query(audio_stream->envelope, channel, start_sample, samples_per_column, nb_columns, output);
+    tracked_mutex_unlock(&audio_stream->envelope_lock);
+    if (from_envelope) {
+        return;
     }
 
-    for (int i = 0; i < nb_samples * nb_channels; i++) {
-        maxes[i % nb_channels] = to_normalize[i] > maxes[i % nb_channels] ? to_normalize[i] : maxes[i % nb_channels];
+    tracked_mutex_lock(&audio_stream->lock);
+    const size_t buffer_start = audio_stream_start_sample(audio_stream);
+    if (start_sample < buffer_start || start_sample >= buffer_start + audio_stream->nb_samples) {
+        tracked_mutex_unlock(&audio_stream->lock);
+        for (int i = 0; i < nb_columns; i++) {
+            output[i].filled = 0;
+        }
+        return;
     }
 
-    for (int i = 0; i < nb_samples * nb_channels; i++) {
-        to_normalize[i] /= maxes[i % nb_channels];
-    }
+    const size_t offset = start_sample - buffer_start;
+    waveform_columns_from_samples(audio_stream->stream + offset * audio_stream->nb_channels, audio_stream->nb_samples - offset,
+            channel, audio_stream->nb_channels, samples_per_column, nb_columns, output);
+    tracked_mutex_unlock(&audio_stream->lock);
 }
 
-void print_wave(int x, int y, int width, int height, float* wave, int nb_samples, int channel_index, int nb_channels, int use_color) {
+void print_wave(int x, int y, int width, int height, WaveformColumn* columns, int nb_columns, int channel_index, int nb_channels, int use_color) {
     const int midline = y + (height / 2);
+    const double half_height = (double)height / 2;
     int color_pair;
     if (use_color) {
         rgb color;
@@ -245,16 +365,26 @@ void print_wave(int x, int y, int width, int height, float* wave, int nb_samples
         attron(COLOR_PAIR(color_pair));
     }
 
-    for (int i = channel_index; i < i32min(nb_samples, width) * nb_channels; i += nb_channels) {
-        if (wave[i] == 0.0f) {
+    float peak = 0.0f;
+    for (int i = 0; i < nb_columns; i++) {
+        if (columns[i].filled) {
+            peak = fmaxf(peak, fmaxf(fabsf(columns[i].min), fabsf(columns[i].max)));
+        }
+    }
+    const float scale = peak > 0.0f ? 1.0f / peak : 1.0f;
+
+    for (int i = 0; i < i32min(nb_columns, width); i++) {
+        if (!columns[i].filled) {
             continue;
         }
 
-        for (int top = midline - (int)((double)height / 2 * wave[i]); top != midline; top += fsignum(wave[i])) {
-            mvaddch(top, x + i / nb_channels, '*');
-            if (top < 0 || top > LINES) { break; }
+        const int top = i32max(y, midline - (int)(half_height * columns[i].max * scale));
+        const int bottom = i32min(y + height - 1, midline - (int)(half_height * columns[i].min * scale));
+        const int rms_extent = (int)(half_height * columns[i].rms * scale);
+        for (int row = top; row <= bottom; row++) {
+            mvaddch(row, x + i, row >= midline - rms_extent && row <= midline + rms_extent ? '#' : '*');
         }
-        mvaddch(midline, x + i / nb_channels, '*');
+        mvaddch(midline, x + i, '*');
     }
 
     mvprintw(midline, (COLS / 2) - 6, "Channel #%d", channel_index);
@@ -264,107 +394,253 @@ void print_wave(int x, int y, int width, int height, float* wave, int nb_samples
     }
 } 
 
+void print_waveform_overview(int y, WaveformColumn* columns, int nb_columns, double progress) {
+    const char* ramp = " .:-=+*#%@";
+    const int ramp_length = strlen(ramp);
+    const int playhead_column = nb_columns * fmax(0.0, fmin(1.0, progress));
+
+    for (int i = 0; i < nb_columns; i++) {
+        char display = ' ';
+        if (i == playhead_column) {
+            display = '|';
+        } else if (columns[i].filled) {
+            const float peak = fmaxf(fabsf(columns[i].min), fabsf(columns[i].max));
+            display = ramp[1 + i32min(ramp_length - 2, (int)(peak * (ramp_length - 2)))];
+        }
+        mvaddch(y, i, display);
+    }
+}
+
 void render_audio_screen(MediaPlayer *player, GuiData gui_data) {
     erase();
     const MediaDisplayCache* cache = player->displayCache;
     AudioStream* audio_stream = cache->audio_stream;
-    if (audio_stream->stream == NULL || audio_stream->nb_samples == 0 || audio_stream->nb_channels == 0) {
+    tracked_mutex_lock(&audio_stream->lock);
+    if (audio_stream->stream == NULL || audio_stream->nb_samples == 0 || audio_stream->nb_channels == 0 || COLS <= 0) {
+        tracked_mutex_unlock(&audio_stream->lock);
         printw("%s\n", "CURRENTLY NO AUDIO DATA TO DISPLAY");
         return;
     }
 
-    const int shown_sample_size = 8192 * 2;
-    if (audio_stream->playhead + shown_sample_size >= audio_stream->nb_samples) {
-        printw("%s\n", "CURRENTLY NOT ENOUGH AUDIO DATA TO DISPLAY");
-        return;
-    }
+    const int nb_channels = audio_stream->nb_channels;
+    const int sample_rate = audio_stream->sample_rate;
+    const size_t samples_per_column = gui_data.audio.shown_samples > (size_t)COLS ? gui_data.audio.shown_samples / COLS : 1;
+    const size_t window_start = audio_stream_start_sample(audio_stream) + audio_stream->playhead;
+    AudioMeter meter = cache->audio_meter;
+    tracked_mutex_unlock(&audio_stream->lock);
 
-    float wave[COLS * audio_stream->nb_channels];
-    for (int i = 0; i < COLS * audio_stream->nb_channels; i++) {
-        wave[i] = 0.0f;
-    }
-
-    uint8_t* last_samples_compressed = audio_stream->stream + (audio_stream->playhead * audio_stream->nb_channels);
-    float last_samples[shown_sample_size * audio_stream->nb_channels];
-
-    for (int i = 0; i < shown_sample_size * audio_stream->nb_channels; i++) {
-        last_samples[i] = uint8_sample_to_float(last_samples_compressed[i]);
+    WaveformColumn columns[COLS * nb_channels];
+    for (int i = 0; i < nb_channels; i++) {
+        get_waveform_columns(audio_stream, i, window_start, samples_per_column, COLS, columns + i * COLS);
     }
 
-    if (shown_sample_size < COLS) {
-        expand_wave(wave, COLS, last_samples, shown_sample_size, audio_stream->nb_channels);
-    } else if (shown_sample_size > COLS) {
-        collapse_wave(wave, COLS, last_samples, shown_sample_size, audio_stream->nb_channels);
-    } else {
-        for (int i = 0; i < COLS * audio_stream->nb_channels; i++) {
-            wave[i] = last_samples[i];
-        } 
+    const double duration = player->timeline->mediaData->duration;
+    const size_t total_samples = duration * sample_rate;
+    const size_t overview_samples_per_column = total_samples > (size_t)COLS ? total_samples / COLS : 1;
+    WaveformColumn overview[COLS];
+    WaveformColumn overview_channel[COLS];
+    for (int i = 0; i < nb_channels; i++) {
+        get_waveform_columns(audio_stream, i, 0, overview_samples_per_column, COLS, i == 0 ? overview : overview_channel);
+        for (int col = 0; i > 0 && col < COLS; col++) {
+            if (overview_channel[col].filled) {
+                overview[col].min = overview[col].filled ? fminf(overview[col].min, overview_channel[col].min) : overview_channel[col].min;
+                overview[col].max = overview[col].filled ? fmaxf(overview[col].max, overview_channel[col].max) : overview_channel[col].max;
+                overview[col].filled = 1;
+            }
+        }
     }
-    normalize_wave(wave, COLS, audio_stream->nb_channels);
+    const double window_time = (double)window_start / sample_rate;
 
+    const int wave_top = 2;
+    const int wave_height = LINES - wave_top - 1;
     if (gui_data.audio.show_all_channels) {
-        for (int i = 0; i < audio_stream->nb_channels; i++) {
-            print_wave(0, i * ( LINES / audio_stream->nb_channels), COLS, LINES / audio_stream->nb_channels, wave, COLS, i, audio_stream->nb_channels, player->displaySettings->use_colors);
+        for (int i = 0; i < nb_channels; i++) {
+            print_wave(0, wave_top + i * (wave_height / nb_channels), COLS, wave_height / nb_channels, columns + i * COLS, COLS, i, nb_channels, player->displaySettings->use_colors);
         }
     } else {
-        print_wave(0, 0, COLS, LINES, wave, COLS, gui_data.audio.channel_index, audio_stream->nb_channels, player->displaySettings->use_colors);
+        print_wave(0, wave_top, COLS, wave_height, columns + gui_data.audio.channel_index * COLS, COLS, gui_data.audio.channel_index, nb_channels, player->displaySettings->use_colors);
     }
+    print_waveform_overview(1, overview, COLS, duration > 0.0 ? window_time / duration : 0.0);
 
     const char* format = "Press 0 to see all Channels, Otherwise, press a number to see its specific channel: ";
-    mvprintw(0, (COLS / 2) - (strlen(format) + audio_stream->nb_channels * 3 + 6) / 2, "%s%s", format, gui_data.audio.show_all_channels == 1 ? "|All Channels (0)| " : "All Channels (0) ");
-    for (int i = 0; i < audio_stream->nb_channels; i++) {
+    mvprintw(0, (COLS / 2) - (strlen(format) + nb_channels * 3 + 6) / 2, "%s%s", format, gui_data.audio.show_all_channels == 1 ? "|All Channels (0)| " : "All Channels (0) ");
+    for (int i = 0; i < nb_channels; i++) {
         printw(gui_data.audio.channel_index == i && !gui_data.audio.show_all_channels ? "|%d| " : "%d ", i + 1);  
     }
+    printw("(+/- zoom: %.2f s)", (double)samples_per_column * COLS / sample_rate);
+
+    render_audio_meter(player, &meter, LINES - 1);
+}
+
+void render_spectrum_screen(MediaPlayer* player) {
+    erase();
+    MediaDisplayCache* cache = player->displayCache;
+    AudioStream* audio_stream = cache->audio_stream;
+    SpectrumAnalyzer* analyzer = cache->spectrum;
+    float bands[SPECTRUM_NB_BANDS];
+    float history[SPECTRUM_HISTORY_LENGTH][SPECTRUM_NB_BANDS];
+
+    tracked_mutex_lock(&audio_stream->lock);
+    const unsigned long nb_hops = analyzer->nb_hops;
+    const int sample_rate = analyzer->sample_rate;
+    memcpy(bands, analyzer->bands, sizeof(bands));
+    for (int row = 0; row < SPECTRUM_HISTORY_LENGTH; row++) {
+        const int source_row = (analyzer->history_head - 1 - row + SPECTRUM_HISTORY_LENGTH) % SPECTRUM_HISTORY_LENGTH;
+        memcpy(history[row], analyzer->history[source_row], sizeof(history[row]));
+    }
+    AudioMeter meter = cache->audio_meter;
+    tracked_mutex_unlock(&audio_stream->lock);
+
+    if (nb_hops == 0 || COLS <= 0) {
+        printw("%s\n", "CURRENTLY NO AUDIO DATA TO ANALYZE");
+        return;
+    }
+
+    mvprintw(0, 0, "Spectrum %.0f Hz - %.0f Hz | %d point FFT, %d sample hop", SPECTRUM_MIN_FREQUENCY, sample_rate / 2.0, SPECTRUM_FFT_SIZE, SPECTRUM_HOP_SIZE);
+    const int spectrum_top = 1;
+    const int spectrum_height = (LINES - 2) / 2;
+    const int spectrogram_top = spectrum_top + spectrum_height;
+    const int spectrogram_height = i32min(LINES - 1 - spectrogram_top, SPECTRUM_HISTORY_LENGTH);
+    const char* ramp = " .:-=+*#%@";
+    const int ramp_length = strlen(ramp);
+
+    for (int col = 0; col < COLS; col++) {
+        const int band = col * SPECTRUM_NB_BANDS / COLS;
+        const double level = fmax(0.0, fmin(1.0, (bands[band] - SPECTRUM_FLOOR_DB) / -SPECTRUM_FLOOR_DB));
+        const int bar_height = level * spectrum_height;
+        for (int row = 0; row < bar_height; row++) {
+            mvaddch(spectrum_top + spectrum_height - 1 - row, col, '|');
+        }
+
+        for (int row = 0; row < spectrogram_height; row++) {
+            const double cell = fmax(0.0, fmin(1.0, (history[row][band] - SPECTRUM_FLOOR_DB) / -SPECTRUM_FLOOR_DB));
+            mvaddch(spectrogram_top + row, col, ramp[(int)(cell * (ramp_length - 1))]);
+        }
+    }
+
+    render_audio_meter(player, &meter, LINES - 1);
+}
+
+void render_audio_meter(MediaPlayer* player, AudioMeter* meter, int y) {
+    const double floor_dbfs = -60.0;
+    const double peak_dbfs = audio_meter_peak_dbfs(meter);
+    const double hold_dbfs = audio_meter_hold_dbfs(meter);
+
+    char status[128];
+    const int status_len = snprintf(status, 128, "Volume %3d%% | Peak %6.1f dBFS | Clipped %lu ", (int)(player->timeline->playback->volume * 100), peak_dbfs, meter->clipped_samples);
+    mvprintw(y, 0, "%s", status);
+
+    const int bar_width = COLS - status_len - 2;
+    if (bar_width <= 0) {
+        return;
+    }
 
+    const int filled = bar_width * fmax(0.0, (peak_dbfs - floor_dbfs) / -floor_dbfs);
+    const int hold = (bar_width - 1) * fmax(0.0, (hold_dbfs - floor_dbfs) / -floor_dbfs);
+    addch('[');
+    for (int i = 0; i < bar_width; i++) {
+        addch(i < filled ? '#' : i == hold ? '|' : ' ');
+    }
+    addch(']');
 }
 
 void print_debug(MediaDebugInfo* debug_info, const char* source, const char* type) {
+    tracked_mutex_lock(&debug_info->lock);
+    const int nb_messages = debug_info->nb_messages;
     for (int i = 0; i < debug_info->nb_messages; i++) {
         if (strcmp(source, debug_info->messages[i]->source) == 0 && strcmp(type, debug_info->messages[i]->type) == 0) {
             printw("%s", debug_info->messages[i]->message);
         }
     }
+    tracked_mutex_unlock(&debug_info->lock);
+
+    if (nb_messages == MEDIA_DEBUG_MESSAGE_BUFFER_SIZE) {
+        clear_media_debug(debug_info, source, type);
+    }
+}
+
+void print_wakeup_rates(PlayerState* state) {
+    double rates[NUMBER_OF_PLAYER_THREADS];
+    player_state_get_wakeup_rates(state, rates);
+    printw("%s", "Wakeups per second:");
+    for (int i = 0; i < NUMBER_OF_PLAYER_THREADS; i++) {
+        printw(" %s %.1f", player_thread_name(i), rates[i]);
+    }
+    printw("\n");
+}
+
+void print_lock_contention(MediaPlayer* player) {
+    TrackedMutex* locks[MAX_TRACKED_LOCKS];
+    const int nb_locks = get_media_player_locks(player, locks, MAX_TRACKED_LOCKS);
+    printw("%-14s %10s %10s %12s %12s\n", "Lock", "Acquired", "Contended", "Waited (ms)", "Max (ms)");
+    for (int i = 0; i < nb_locks; i++) {
+        TrackedMutexStats stats;
+        tracked_mutex_get_stats(locks[i], &stats);
+        printw("%-14s %10lu %10lu %12.3f %12.3f\n", stats.name, stats.acquisitions, stats.contentions, stats.wait_time * SECONDS_TO_MILLISECONDS, stats.max_wait_time * SECONDS_TO_MILLISECONDS);
+    }
+    printw("\n");
+}
+
+void print_graphics_output(MediaPlayer* player) {
+    MediaDisplayCache* cache = player->displayCache;
+    if (cache->graphics_frame_bytes == 0) {
+        return;
+    }
+
+    printw("Graphics Output %s: %zu bytes/frame, %.1f us encode, %dx%d cells\n\n", graphics_protocol_string(player->displaySettings->graphics_protocol),
+            cache->graphics_frame_bytes, cache->graphics_encode_time * 1e6, cache->graphics_columns, cache->graphics_rows);
+}
+
+void print_frame_arena(FrameArena* arena) {
+    if (arena->last_frame.allocs == 0) {
+        return;
+    }
+
+    printw("Frame Arena: %zu bytes, %lu allocs, %lu system allocs last frame, %zu byte capacity\n\n",
+            arena->last_frame.bytes, arena->last_frame.allocs, arena->last_frame.system_allocs, arena->capacity);
+}
+
+void print_overlay_cache(OverlayCache* overlay_cache) {
+    if (overlay_cache->nb_entries == 0) {
+        return;
+    }
+
+    printw("Overlay Cache: %lu hits, %lu misses, %d cached images\n\n", overlay_cache->nb_hits, overlay_cache->nb_misses, overlay_cache->nb_entries);
 }
 
 void render_audio_debug(MediaPlayer* player, GuiData gui_data) {
     erase();
+    print_wakeup_rates(player->state);
+    print_lock_contention(player);
+    print_debug(player->displayCache->debug_info, "loader", "debug");
     print_debug(player->displayCache->debug_info, "audio", "debug");
-    if (player->displayCache->debug_info->nb_messages == MEDIA_DEBUG_MESSAGE_BUFFER_SIZE) {
-        clear_media_debug(player->displayCache->debug_info, "audio", "debug");
-    }
 }
 
 void render_video_debug(MediaPlayer *player, GuiData gui_data) {
     erase();
+    print_wakeup_rates(player->state);
+    print_lock_contention(player);
+    print_frame_arena(player->displayCache->frame_arena);
+    print_graphics_output(player);
+    print_overlay_cache(player->displayCache->overlay_cache);
+    print_debug(player->displayCache->debug_info, "loader", "debug");
     print_debug(player->displayCache->debug_info, "video", "debug");
-    if (player->displayCache->debug_info->nb_messages == MEDIA_DEBUG_MESSAGE_BUFFER_SIZE) {
-        clear_media_debug(player->displayCache->debug_info, "video", "debug");
-    }
 }
 
-AsciiImage* stitch_video(MediaPlayer* player, int width, int height) {
+int overlay_video_symbols(MediaPlayer* player, AsciiImage* textImage) {
     VideoSymbolStack* symbol_stack = player->displayCache->symbol_stack;
-    AsciiImage* textImage = get_ascii_image_bounded(player->displayCache->image, width, height);
-    if (textImage == NULL) {
-        return NULL;
-    }
-
+    OverlayCache* overlay_cache = player->displayCache->overlay_cache;
+    const int colored = player->displaySettings->use_colors;
     while (player->displayCache->symbol_stack->top >= 0) {
         VideoSymbol* currentSymbol = video_symbol_stack_peek(symbol_stack); 
         if (clock_sec() - currentSymbol->startTime < currentSymbol->lifeTime) {
             int currentSymbolFrame = get_video_symbol_current_frame(currentSymbol); 
-            AsciiImage* symbolImage = get_ascii_image_bounded(currentSymbol->frameData[currentSymbolFrame], textImage->width, textImage->height);
+            AsciiImage* symbolImage = overlay_cache_get(overlay_cache, currentSymbol->frameData[currentSymbolFrame], textImage->width, textImage->height, colored);
             if (symbolImage == NULL) {
-                free(textImage);
-                return NULL;
-            }
-
-            if (player->displaySettings->use_colors) {
-                ascii_init_color(symbolImage);
+                return 0;
             }
 
             overlap_ascii_images(textImage, symbolImage);
-            ascii_image_free(symbolImage);
             break;
         } else {
             video_symbol_stack_erase_pop(symbol_stack);
@@ -372,31 +648,201 @@ AsciiImage* stitch_video(MediaPlayer* player, int width, int height) {
     }
 
     if (!player->timeline->playback->playing) {
-        VideoSymbol* pauseSymbol = get_video_symbol(PAUSE_ICON);
-        AsciiImage* symbolImage = get_ascii_image_bounded(pauseSymbol->frameData[0], textImage->width, textImage->height);
+        PixelData* pauseIcon = get_video_icon(PAUSE_ICON);
+        AsciiImage* symbolImage = pauseIcon != NULL ? overlay_cache_get(overlay_cache, pauseIcon, textImage->width, textImage->height, colored) : NULL;
         if (symbolImage == NULL) {
-            free(textImage);
-            return NULL;
-        }
-
-        if (player->displaySettings->use_colors) {
-            ascii_init_color(symbolImage);
+            return 0;
         }
 
         overlap_ascii_images(textImage, symbolImage);
-        free_video_symbol(pauseSymbol);
-        ascii_image_free(symbolImage);
+    }
+    return 1;
+}
+
+AsciiImage* stitch_video(MediaPlayer* player, int width, int height) {
+    AsciiImage* textImage = player->displaySettings->equalize ?
+        get_ascii_image_equalized(player->displayCache->last_rendered_image, width, height, &player->displayCache->equalizer) :
+        get_ascii_image_bounded(player->displayCache->last_rendered_image, width, height);
+    if (textImage == NULL) {
+        return NULL;
+    }
+
+    if (!overlay_video_symbols(player, textImage)) {
+        ascii_image_free(textImage);
+        return NULL;
     }
 
     return textImage;
 }
 
+void render_subcell_movie(MediaPlayer* player, int width, int height) {
+    const RenderMethod method = player->displaySettings->render_method;
+    const int cell_width = method == RENDER_METHOD_BRAILLE ? BRAILLE_CELL_WIDTH : 1;
+    const int cell_height = method == RENDER_METHOD_BRAILLE ? BRAILLE_CELL_HEIGHT : 2;
+    PixelData* image = player->displayCache->last_rendered_image;
+    int outputWidth, outputHeight;
+    get_output_size(image->width, image->height, width * cell_width, height * cell_height, &outputWidth, &outputHeight);
+    PixelData* reduced = outputWidth < image->width || outputHeight < image->height ? get_pixel_data_reduced(image, outputWidth, outputHeight) : image;
+    if (reduced == NULL) {
+        return;
+    }
+
+    const int nb_cell_columns = (reduced->width + cell_width - 1) / cell_width;
+    const int nb_cell_rows = (reduced->height + cell_height - 1) / cell_height;
+    const int top = (height - nb_cell_rows) / 2;
+    const int left = (width - nb_cell_columns) / 2;
+    if (method == RENDER_METHOD_BRAILLE) {
+        print_braille_image(reduced, top, left, player->displaySettings->dither);
+    } else {
+        print_half_block_image(reduced, top, left);
+    }
+
+    if (reduced != image) {
+        pixel_data_free(reduced);
+    }
+
+    AsciiImage* overlay = ascii_image_alloc(nb_cell_columns, nb_cell_rows, 0);
+    if (overlay == NULL) {
+        return;
+    }
+
+    memset(overlay->glyphs, GLYPH_NONE, overlay->width * overlay->height);
+    if (overlay_video_symbols(player, overlay)) {
+        for (int row = 0; row < overlay->height; row++) {
+            for (int col = 0; col < overlay->width; col++) {
+                if (overlay->glyphs[row * overlay->width + col] != GLYPH_NONE) {
+                    mvaddstr(top + row, left + col, ascii_image_glyph(overlay, row * overlay->width + col));
+                }
+            }
+        }
+    }
+    ascii_image_free(overlay);
+}
+
+void render_graphics_movie(MediaPlayer* player, int width, int height) {
+    MediaDisplayCache* cache = player->displayCache;
+    const GraphicsProtocol protocol = player->displaySettings->graphics_protocol;
+    if (cache->graphics_buffer == NULL) {
+        cache->graphics_buffer = graphics_buffer_alloc();
+        if (cache->graphics_buffer == NULL) {
+            return;
+        }
+    }
+
+    int cell_width, cell_height;
+    get_terminal_cell_pixel_size(&cell_width, &cell_height);
+    const int area_width = width * cell_width;
+    const int area_height = height * cell_height;
+
+    PixelData* image = cache->last_rendered_image;
+    int outputWidth, outputHeight;
+    get_output_size(image->width, image->height, area_width, area_height, &outputWidth, &outputHeight);
+    PixelData* fitted = outputWidth < image->width || outputHeight < image->height ? get_pixel_data_reduced(image, outputWidth, outputHeight) : image;
+    if (fitted == NULL) {
+        return;
+    }
+
+    const double start = clock_sec();
+    GraphicsBuffer* buffer = cache->graphics_buffer;
+    buffer->size = 0;
+    int columns, rows, success;
+    if (protocol == GRAPHICS_PROTOCOL_SIXEL) {
+        const int scale = i32max(1, i32min(area_width / fitted->width, area_height / fitted->height));
+        columns = (fitted->width * scale + cell_width - 1) / cell_width;
+        rows = (fitted->height * scale + cell_height - 1) / cell_height;
+        success = encode_sixel_image(buffer, fitted, scale);
+    } else {
+        const double scale = fmin((double)area_width / fitted->width, (double)area_height / fitted->height);
+        columns = i32max(1, fitted->width * scale / cell_width);
+        rows = i32max(1, fitted->height * scale / cell_height);
+        success = encode_kitty_image(buffer, fitted, columns, rows);
+    }
+    const double encode_time = clock_sec() - start;
+
+    if (fitted != image) {
+        pixel_data_free(fitted);
+    }
+
+    if (success) {
+        refresh();
+        write_graphics_image(buffer, (height - rows) / 2, (width - columns) / 2);
+        cache->graphics_visible = 1;
+        cache->graphics_frame_bytes = buffer->size;
+        cache->graphics_encode_time = encode_time;
+        cache->graphics_columns = columns;
+        cache->graphics_rows = rows;
+    }
+}
+
+void hide_graphics_output(MediaPlayer* player) {
+    if (!player->displayCache->graphics_visible) {
+        return;
+    }
+
+    clear_graphics_images(player->displaySettings->graphics_protocol);
+    clearok(curscr, TRUE);
+    player->displayCache->graphics_visible = 0;
+}
+
+RenderMethod get_active_render_method(MediaPlayer* player) {
+    const RenderMethod method = player->displaySettings->render_method;
+    if (method == RENDER_METHOD_GRAPHICS && player->displaySettings->graphics_protocol == GRAPHICS_PROTOCOL_NONE) {
+        return RENDER_METHOD_ASCII;
+    } else if (method == RENDER_METHOD_HALF_BLOCK && !has_colors()) {
+        return RENDER_METHOD_ASCII;
+    }
+    return method;
+}
+
+int get_movie_screen_height(GuiData gui_data) {
+    return LINES - (gui_data.video.fullscreen ? 0 : 5);
+}
+
+void reconfigure_display(MediaPlayer* player, GuiData gui_data) {
+    MediaDisplayCache* cache = player->displayCache;
+    DisplayGeometry geometry = { COLS, get_movie_screen_height(gui_data), get_active_render_method(player), 0, 0 };
+    MediaStream* video_stream = get_media_stream(player->timeline->mediaData, AVMEDIA_TYPE_VIDEO);
+    if (video_stream != NULL && geometry.columns > 0 && geometry.rows > 0) {
+        AVCodecContext* codec_context = video_stream->info->codecContext;
+        get_video_frame_target(codec_context->width, codec_context->height, geometry.method, geometry.columns, geometry.rows, &geometry.frame_width, &geometry.frame_height);
+    }
+
+    hide_graphics_output(player);
+    overlay_cache_clear(cache->overlay_cache);
+    publish_display_geometry(cache, &geometry);
+
+    tracked_mutex_lock(&cache->lock);
+    if (cache->last_rendered_image != NULL) {
+        pixel_data_free(cache->last_rendered_image);
+        cache->last_rendered_image = NULL;
+    }
+    tracked_mutex_unlock(&cache->lock);
+    player_state_notify(player->state);
+}
+
 void render_movie_screen(MediaPlayer* player, GuiData gui_data) {
     erase();
-    if (player->displayCache->image == NULL) {
+    if (player->displayCache->last_rendered_image == NULL) {
+        return;
+    }
+    const int height = get_movie_screen_height(gui_data);
+    const RenderMethod method = get_active_render_method(player);
+
+    if (method == RENDER_METHOD_GRAPHICS) {
+        if (!gui_data.video.fullscreen) {
+            render_playbar(player, gui_data);
+        }
+        render_graphics_movie(player, COLS, height);
+        return;
+    } else if (method == RENDER_METHOD_BRAILLE || method == RENDER_METHOD_HALF_BLOCK) {
+        render_subcell_movie(player, COLS, height);
+        if (!gui_data.video.fullscreen) {
+            render_playbar(player, gui_data);
+        }
         return;
     }
-    AsciiImage* textImage = stitch_video(player, COLS, LINES - (gui_data.video.fullscreen ? 0 : 5));
+
+    AsciiImage* textImage = stitch_video(player, COLS, height);
     if (textImage == NULL) {
         return;
     }
@@ -427,7 +873,7 @@ void fill_with_char(char* str, int len, char ch) {
 }
 
 typedef struct ScreenChar {
-    char character;
+    uint8_t glyph;
     int row;
     int col;
 } ScreenChar;
@@ -451,61 +897,62 @@ void print_ascii_image_full(AsciiImage* textImage) {
     const int max_color_pairs = i32min(COLORS - 8, COLOR_PAIRS);
 
     if (textImage->colored && max_color_pairs > 16) {
-        ScreenChar* char_buckets[COLOR_PAIRS];
-        int char_buckets_lengths[COLOR_PAIRS];
-        int char_buckets_capacities[COLOR_PAIRS];
-        for (int i = 0; i < COLOR_PAIRS; i++) {
-            char_buckets[i] = NULL;
-            char_buckets_lengths[i] = 0;
-            char_buckets_capacities[i] = 0;
-        }
-
-        for (int row = 0; row < textImage->height; row++) {
-            for (int col = 0; col < textImage->width; col++) {
-                int target_pair = get_closest_color_pair(textImage->color_data[row * textImage->width + col]);
-                if (char_buckets[target_pair] == NULL) {
-                    char_buckets[target_pair] = (ScreenChar*)malloc(sizeof(ScreenChar) * 10);
-                    if (char_buckets[target_pair] == NULL) {
-                        continue;
-                    }
-                    char_buckets_capacities[target_pair] = 10;
-                }
+        const int nb_cells = textImage->width * textImage->height;
+        FrameArena* arena;
+        FrameArena* cell_arena;
+        int* bucket_starts = (int*)frame_arena_malloc(sizeof(int) * (COLOR_PAIRS + 1), &arena);
+        short* cell_pairs = (short*)frame_arena_malloc(sizeof(short) * nb_cells, &cell_arena);
+        ScreenChar* screen_chars = (ScreenChar*)frame_arena_malloc(sizeof(ScreenChar) * nb_cells, &cell_arena);
+        if (bucket_starts == NULL || cell_pairs == NULL || screen_chars == NULL) {
+            if (bucket_starts != NULL) {
+                frame_arena_release(bucket_starts, arena);
+            }
+            if (cell_pairs != NULL) {
+                frame_arena_release(cell_pairs, cell_arena);
+            }
+            if (screen_chars != NULL) {
+                frame_arena_release(screen_chars, cell_arena);
+            }
+            return;
+        }
 
-                if (char_buckets_lengths[target_pair] >= char_buckets_capacities[target_pair]) {
-                    ScreenChar* tmp = (ScreenChar*)realloc(char_buckets[target_pair], sizeof(ScreenChar) * char_buckets_capacities[target_pair] * 2);
-                    if (tmp != NULL) {
-                        char_buckets[target_pair] = tmp;
-                        char_buckets_capacities[target_pair] *= 2;
-                    }
-                }
+        memset(bucket_starts, 0, sizeof(int) * (COLOR_PAIRS + 1));
+        for (int i = 0; i < nb_cells; i++) {
+            cell_pairs[i] = get_closest_color_pair(textImage->color_data[i]);
+            bucket_starts[cell_pairs[i] + 1]++;
+        }
 
-                if (char_buckets_lengths[target_pair] < char_buckets_capacities[target_pair]) {
-                    char_buckets[target_pair][char_buckets_lengths[target_pair]] = (ScreenChar){ textImage->lines[row * textImage->width + col], row, col };
-                    char_buckets_lengths[target_pair] += 1;
-                }
-            }
+        for (int b = 0; b < COLOR_PAIRS; b++) {
+            bucket_starts[b + 1] += bucket_starts[b];
+        }
+
+        for (int i = 0; i < nb_cells; i++) {
+            screen_chars[bucket_starts[cell_pairs[i]]++] = (ScreenChar){ textImage->glyphs[i], i / textImage->width, i % textImage->width };
         }
 
+        int start = 0;
         for (int b = 0; b < COLOR_PAIRS; b++) {
-            if (char_buckets[b] == NULL) {
+            const int end = bucket_starts[b];
+            if (end == start) {
                 continue;
             }
 
             attron(COLOR_PAIR(b));
-            for (int i = 0; i < char_buckets_lengths[b]; i++) {
-                mvaddch(verticalPaddingHeight + char_buckets[b][i].row, horizontalPaddingWidth + char_buckets[b][i].col, char_buckets[b][i].character);
-            }
-
-            if (char_buckets[b] != NULL) {
-                free(char_buckets[b]);
+            for (int i = start; i < end; i++) {
+                mvaddstr(verticalPaddingHeight + screen_chars[i].row, horizontalPaddingWidth + screen_chars[i].col, textImage->ramp->glyphs[screen_chars[i].glyph]);
             }
             attroff(COLOR_PAIR(b));
+            start = end;
         }
+
+        frame_arena_release(screen_chars, cell_arena);
+        frame_arena_release(cell_pairs, cell_arena);
+        frame_arena_release(bucket_starts, arena);
     } else {
         for (int row = 0; row < i32min(textImage->height, LINES); row++) {
             printw("%s|", horizontalPadding);
             for (int col = 0; col < i32min(textImage->width, COLS); col++) {
-                addch(textImage->lines[row * textImage->width + col]);
+                addstr(ascii_image_glyph(textImage, row * textImage->width + col));
             }
             addstr("|\n");
         }
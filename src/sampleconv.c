@@ -0,0 +1,426 @@
+#include <sampleconv.h>
+#include <pthread.h>
+#include <string.h>
+#include <math.h>
+
+typedef float float4 __attribute__((vector_size(16)));
+typedef int32_t int4 __attribute__((vector_size(16)));
+typedef uint8_t uchar4 __attribute__((vector_size(4)));
+typedef int16_t short4 __attribute__((vector_size(8)));
+
+float4 peak_float4(float4 peaks, float4 block);
+float reduce_peak_float4(float4 peaks);
+float u8_to_f32_generic(float* dst, const uint8_t* src, int nb_samples, float gain);
+float s16_to_f32_generic(float* dst, const int16_t* src, int nb_samples, float gain);
+float f32_to_f32_generic(float* dst, const float* src, int nb_samples, float gain);
+float u8_to_f32_resampled_generic(float* dst, const uint8_t* src, int nb_frames, int nb_channels, double phase, double step, float gain);
+void interleave_f32_generic(float* dst, const float* const* src, int nb_frames, int nb_channels);
+void deinterleave_f32_generic(float* const* dst, const float* src, int nb_frames, int nb_channels);
+float u8_to_f32_resampled_tail(float* dst, const uint8_t* src, int first_frame, int nb_frames, int nb_channels, double phase, double step, float scale, float peak);
+void interleave_f32_scalar(float* dst, const float* const* src, int first_frame, int nb_frames, int nb_channels);
+void deinterleave_f32_scalar(float* const* dst, const float* src, int first_frame, int nb_frames, int nb_channels);
+
+const SampleConversionKernels generic_kernels = {
+    "generic", u8_to_f32_generic, s16_to_f32_generic, f32_to_f32_generic, u8_to_f32_resampled_generic, interleave_f32_generic, deinterleave_f32_generic
+};
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SAMPLECONV_AVX2
+typedef float float8 __attribute__((vector_size(32)));
+typedef int32_t int8 __attribute__((vector_size(32)));
+typedef uint8_t uchar8 __attribute__((vector_size(8)));
+typedef int16_t short8 __attribute__((vector_size(16)));
+
+float8 peak_float8(float8 peaks, float8 block);
+float reduce_peak_float8(float8 peaks);
+float u8_to_f32_avx2(float* dst, const uint8_t* src, int nb_samples, float gain);
+float s16_to_f32_avx2(float* dst, const int16_t* src, int nb_samples, float gain);
+float f32_to_f32_avx2(float* dst, const float* src, int nb_samples, float gain);
+float u8_to_f32_resampled_avx2(float* dst, const uint8_t* src, int nb_frames, int nb_channels, double phase, double step, float gain);
+void interleave_f32_avx2(float* dst, const float* const* src, int nb_frames, int nb_channels);
+void deinterleave_f32_avx2(float* const* dst, const float* src, int nb_frames, int nb_channels);
+
+const SampleConversionKernels avx2_kernels = {
+    "avx2", u8_to_f32_avx2, s16_to_f32_avx2, f32_to_f32_avx2, u8_to_f32_resampled_avx2, interleave_f32_avx2, deinterleave_f32_avx2
+};
+#endif
+
+const SampleConversionKernels* selected_kernels = &generic_kernels;
+pthread_once_t kernels_selected = PTHREAD_ONCE_INIT;
+
+void select_sample_conversion_kernels() {
+#ifdef SAMPLECONV_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        selected_kernels = &avx2_kernels;
+    }
+#endif
+}
+
+const SampleConversionKernels* get_sample_conversion_kernels() {
+    pthread_once(&kernels_selected, select_sample_conversion_kernels);
+    return selected_kernels;
+}
+
+const SampleConversionKernels* get_generic_sample_conversion_kernels() {
+    return &generic_kernels;
+}
+
+
+float4 peak_float4(float4 peaks, float4 block) {
+    const int4 abs_mask = { 0x7fffffff, 0x7fffffff, 0x7fffffff, 0x7fffffff };
+    float4 magnitude = (float4)((int4)block & abs_mask);
+    int4 louder = magnitude > peaks;
+    return (float4)(((int4)peaks & ~louder) | ((int4)magnitude & louder));
+}
+
+float reduce_peak_float4(float4 peaks) {
+    float peak = 0.0f;
+    for (int lane = 0; lane < 4; lane++) {
+        peak = peaks[lane] > peak ? peaks[lane] : peak;
+    }
+    return peak;
+}
+
+float u8_to_f32_generic(float* dst, const uint8_t* src, int nb_samples, float gain) {
+    const float scale = gain / 128.0f;
+    const float4 scales = { scale, scale, scale, scale };
+    const float4 offsets = { 128.0f, 128.0f, 128.0f, 128.0f };
+    float4 peaks = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    int i = 0;
+    for (; i + 4 <= nb_samples; i += 4) {
+        uchar4 packed;
+        memcpy(&packed, src + i, sizeof(uchar4));
+        float4 block = (__builtin_convertvector(packed, float4) - offsets) * scales;
+        peaks = peak_float4(peaks, block);
+        memcpy(dst + i, &block, sizeof(float4));
+    }
+
+    float peak = reduce_peak_float4(peaks);
+    for (; i < nb_samples; i++) {
+        dst[i] = ((float)src[i] - 128.0f) * scale;
+        peak = fabsf(dst[i]) > peak ? fabsf(dst[i]) : peak;
+    }
+    return peak;
+}
+
+float s16_to_f32_generic(float* dst, const int16_t* src, int nb_samples, float gain) {
+    const float scale = gain / 32768.0f;
+    const float4 scales = { scale, scale, scale, scale };
+    float4 peaks = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    int i = 0;
+    for (; i + 4 <= nb_samples; i += 4) {
+        short4 packed;
+        memcpy(&packed, src + i, sizeof(short4));
+        float4 block = __builtin_convertvector(packed, float4) * scales;
+        peaks = peak_float4(peaks, block);
+        memcpy(dst + i, &block, sizeof(float4));
+    }
+
+    float peak = reduce_peak_float4(peaks);
+    for (; i < nb_samples; i++) {
+        dst[i] = src[i] * scale;
+        peak = fabsf(dst[i]) > peak ? fabsf(dst[i]) : peak;
+    }
+    return peak;
+}
+
+float f32_to_f32_generic(float* dst, const float* src, int nb_samples, float gain) {
+    const float4 gains = { gain, gain, gain, gain };
+    float4 peaks = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    int i = 0;
+    for (; i + 4 <= nb_samples; i += 4) {
+        float4 block;
+        memcpy(&block, src + i, sizeof(float4));
+        block *= gains;
+        peaks = peak_float4(peaks, block);
+        memcpy(dst + i, &block, sizeof(float4));
+    }
+
+    float peak = reduce_peak_float4(peaks);
+    for (; i < nb_samples; i++) {
+        dst[i] = src[i] * gain;
+        peak = fabsf(dst[i]) > peak ? fabsf(dst[i]) : peak;
+    }
+    return peak;
+}
+
+/**
+ * Interpolates four output frames at a time. Each lane sits at its own
+ * fractional source position, so the byte loads and the interleaved stores
+ * stay per lane while the conversion and interpolation are vectorized.
+ */
+float u8_to_f32_resampled_generic(float* dst, const uint8_t* src, int nb_frames, int nb_channels, double phase, double step, float gain) {
+    const float scale = gain / 128.0f;
+    const float4 scales = { scale, scale, scale, scale };
+    const float4 offsets = { 128.0f, 128.0f, 128.0f, 128.0f };
+    float4 peaks = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    int i = 0;
+    for (; i + 4 <= nb_frames; i += 4) {
+        size_t indices[4];
+        float4 fractions;
+        for (int lane = 0; lane < 4; lane++) {
+            const double position = phase + (i + lane) * step;
+            const size_t index = (size_t)position;
+            indices[lane] = index * nb_channels;
+            fractions[lane] = (float)(position - index);
+        }
+
+        for (int ch = 0; ch < nb_channels; ch++) {
+            const uchar4 current = { src[indices[0] + ch], src[indices[1] + ch], src[indices[2] + ch], src[indices[3] + ch] };
+            const uchar4 next = { src[indices[0] + nb_channels + ch], src[indices[1] + nb_channels + ch], src[indices[2] + nb_channels + ch], src[indices[3] + nb_channels + ch] };
+            const float4 a = __builtin_convertvector(current, float4) - offsets;
+            const float4 b = __builtin_convertvector(next, float4) - offsets;
+            const float4 block = (a + (b - a) * fractions) * scales;
+            peaks = peak_float4(peaks, block);
+            for (int lane = 0; lane < 4; lane++) {
+                dst[(i + lane) * nb_channels + ch] = block[lane];
+            }
+        }
+    }
+
+    return u8_to_f32_resampled_tail(dst, src, i, nb_frames, nb_channels, phase, step, scale, reduce_peak_float4(peaks));
+}
+
+void interleave_f32_generic(float* dst, const float* const* src, int nb_frames, int nb_channels) {
+    int i = 0;
+    if (nb_channels == 2) {
+        const int4 low = { 0, 4, 1, 5 };
+        const int4 high = { 2, 6, 3, 7 };
+        for (; i + 4 <= nb_frames; i += 4) {
+            float4 left, right;
+            memcpy(&left, src[0] + i, sizeof(float4));
+            memcpy(&right, src[1] + i, sizeof(float4));
+            const float4 first = __builtin_shuffle(left, right, low);
+            const float4 second = __builtin_shuffle(left, right, high);
+            memcpy(dst + 2 * i, &first, sizeof(float4));
+            memcpy(dst + 2 * i + 4, &second, sizeof(float4));
+        }
+    }
+
+    interleave_f32_scalar(dst, src, i, nb_frames, nb_channels);
+}
+
+void deinterleave_f32_generic(float* const* dst, const float* src, int nb_frames, int nb_channels) {
+    int i = 0;
+    if (nb_channels == 2) {
+        const int4 evens = { 0, 2, 4, 6 };
+        const int4 odds = { 1, 3, 5, 7 };
+        for (; i + 4 <= nb_frames; i += 4) {
+            float4 first, second;
+            memcpy(&first, src + 2 * i, sizeof(float4));
+            memcpy(&second, src + 2 * i + 4, sizeof(float4));
+            const float4 left = __builtin_shuffle(first, second, evens);
+            const float4 right = __builtin_shuffle(first, second, odds);
+            memcpy(dst[0] + i, &left, sizeof(float4));
+            memcpy(dst[1] + i, &right, sizeof(float4));
+        }
+    }
+
+    deinterleave_f32_scalar(dst, src, i, nb_frames, nb_channels);
+}
+
+#ifdef SAMPLECONV_AVX2
+__attribute__((target("avx2")))
+float8 peak_float8(float8 peaks, float8 block) {
+    const int8 abs_mask = { 0x7fffffff, 0x7fffffff, 0x7fffffff, 0x7fffffff, 0x7fffffff, 0x7fffffff, 0x7fffffff, 0x7fffffff };
+    float8 magnitude = (float8)((int8)block & abs_mask);
+    int8 louder = magnitude > peaks;
+    return (float8)(((int8)peaks & ~louder) | ((int8)magnitude & louder));
+}
+
+__attribute__((target("avx2")))
+float reduce_peak_float8(float8 peaks) {
+    float peak = 0.0f;
+    for (int lane = 0; lane < 8; lane++) {
+        peak = peaks[lane] > peak ? peaks[lane] : peak;
+    }
+    return peak;
+}
+
+__attribute__((target("avx2")))
+float u8_to_f32_avx2(float* dst, const uint8_t* src, int nb_samples, float gain) {
+    const float scale = gain / 128.0f;
+    const float8 scales = { scale, scale, scale, scale, scale, scale, scale, scale };
+    const float8 offsets = { 128.0f, 128.0f, 128.0f, 128.0f, 128.0f, 128.0f, 128.0f, 128.0f };
+    float8 peaks = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+    int i = 0;
+    for (; i + 8 <= nb_samples; i += 8) {
+        uchar8 packed;
+        memcpy(&packed, src + i, sizeof(uchar8));
+        float8 block = (__builtin_convertvector(packed, float8) - offsets) * scales;
+        peaks = peak_float8(peaks, block);
+        memcpy(dst + i, &block, sizeof(float8));
+    }
+
+    float peak = reduce_peak_float8(peaks);
+    for (; i < nb_samples; i++) {
+        dst[i] = ((float)src[i] - 128.0f) * scale;
+        peak = fabsf(dst[i]) > peak ? fabsf(dst[i]) : peak;
+    }
+    return peak;
+}
+
+__attribute__((target("avx2")))
+float s16_to_f32_avx2(float* dst, const int16_t* src, int nb_samples, float gain) {
+    const float scale = gain / 32768.0f;
+    const float8 scales = { scale, scale, scale, scale, scale, scale, scale, scale };
+    float8 peaks = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+    int i = 0;
+    for (; i + 8 <= nb_samples; i += 8) {
+        short8 packed;
+        memcpy(&packed, src + i, sizeof(short8));
+        float8 block = __builtin_convertvector(packed, float8) * scales;
+        peaks = peak_float8(peaks, block);
+        memcpy(dst + i, &block, sizeof(float8));
+    }
+
+    float peak = reduce_peak_float8(peaks);
+    for (; i < nb_samples; i++) {
+        dst[i] = src[i] * scale;
+        peak = fabsf(dst[i]) > peak ? fabsf(dst[i]) : peak;
+    }
+    return peak;
+}
+
+__attribute__((target("avx2")))
+float f32_to_f32_avx2(float* dst, const float* src, int nb_samples, float gain) {
+    const float8 gains = { gain, gain, gain, gain, gain, gain, gain, gain };
+    float8 peaks = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+    int i = 0;
+    for (; i + 8 <= nb_samples; i += 8) {
+        float8 block;
+        memcpy(&block, src + i, sizeof(float8));
+        block *= gains;
+        peaks = peak_float8(peaks, block);
+        memcpy(dst + i, &block, sizeof(float8));
+    }
+
+    float peak = reduce_peak_float8(peaks);
+    for (; i < nb_samples; i++) {
+        dst[i] = src[i] * gain;
+        peak = fabsf(dst[i]) > peak ? fabsf(dst[i]) : peak;
+    }
+    return peak;
+}
+
+__attribute__((target("avx2")))
+float u8_to_f32_resampled_avx2(float* dst, const uint8_t* src, int nb_frames, int nb_channels, double phase, double step, float gain) {
+    const float scale = gain / 128.0f;
+    const float8 scales = { scale, scale, scale, scale, scale, scale, scale, scale };
+    const float8 offsets = { 128.0f, 128.0f, 128.0f, 128.0f, 128.0f, 128.0f, 128.0f, 128.0f };
+    float8 peaks = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+    int i = 0;
+    for (; i + 8 <= nb_frames; i += 8) {
+        size_t indices[8];
+        float8 fractions;
+        for (int lane = 0; lane < 8; lane++) {
+            const double position = phase + (i + lane) * step;
+            const size_t index = (size_t)position;
+            indices[lane] = index * nb_channels;
+            fractions[lane] = (float)(position - index);
+        }
+
+        for (int ch = 0; ch < nb_channels; ch++) {
+            uchar8 current, next;
+            for (int lane = 0; lane < 8; lane++) {
+                current[lane] = src[indices[lane] + ch];
+                next[lane] = src[indices[lane] + nb_channels + ch];
+            }
+            const float8 a = __builtin_convertvector(current, float8) - offsets;
+            const float8 b = __builtin_convertvector(next, float8) - offsets;
+            const float8 block = (a + (b - a) * fractions) * scales;
+            peaks = peak_float8(peaks, block);
+            for (int lane = 0; lane < 8; lane++) {
+                dst[(i + lane) * nb_channels + ch] = block[lane];
+            }
+        }
+    }
+
+    return u8_to_f32_resampled_tail(dst, src, i, nb_frames, nb_channels, phase, step, scale, reduce_peak_float8(peaks));
+}
+
+__attribute__((target("avx2")))
+void interleave_f32_avx2(float* dst, const float* const* src, int nb_frames, int nb_channels) {
+    int i = 0;
+    if (nb_channels == 2) {
+        const int8 low = { 0, 8, 1, 9, 2, 10, 3, 11 };
+        const int8 high = { 4, 12, 5, 13, 6, 14, 7, 15 };
+        for (; i + 8 <= nb_frames; i += 8) {
+            float8 left, right;
+            memcpy(&left, src[0] + i, sizeof(float8));
+            memcpy(&right, src[1] + i, sizeof(float8));
+            const float8 first = __builtin_shuffle(left, right, low);
+            const float8 second = __builtin_shuffle(left, right, high);
+            memcpy(dst + 2 * i, &first, sizeof(float8));
+            memcpy(dst + 2 * i + 8, &second, sizeof(float8));
+        }
+    }
+
+    interleave_f32_scalar(dst, src, i, nb_frames, nb_channels);
+}
+
+__attribute__((target("avx2")))
+void deinterleave_f32_avx2(float* const* dst, const float* src, int nb_frames, int nb_channels) {
+    int i = 0;
+    if (nb_channels == 2) {
+        const int8 evens = { 0, 2, 4, 6, 8, 10, 12, 14 };
+        const int8 odds = { 1, 3, 5, 7, 9, 11, 13, 15 };
+        for (; i + 8 <= nb_frames; i += 8) {
+            float8 first, second;
+            memcpy(&first, src + 2 * i, sizeof(float8));
+            memcpy(&second, src + 2 * i + 8, sizeof(float8));
+            const float8 left = __builtin_shuffle(first, second, evens);
+            const float8 right = __builtin_shuffle(first, second, odds);
+            memcpy(dst[0] + i, &left, sizeof(float8));
+            memcpy(dst[1] + i, &right, sizeof(float8));
+        }
+    }
+
+    deinterleave_f32_scalar(dst, src, i, nb_frames, nb_channels);
+}
+#endif
+
+float u8_to_f32_resampled_tail(float* dst, const uint8_t* src, int first_frame, int nb_frames, int nb_channels, double phase, double step, float scale, float peak) {
+    for (int i = first_frame; i < nb_frames; i++) {
+        const double position = phase + i * step;
+        const size_t index = (size_t)position;
+        const float fraction = (float)(position - index);
+        const uint8_t* current = src + index * nb_channels;
+        const uint8_t* next = current + nb_channels;
+        for (int ch = 0; ch < nb_channels; ch++) {
+            const float a = (float)current[ch] - 128.0f;
+            const float b = (float)next[ch] - 128.0f;
+            const float sample = (a + (b - a) * fraction) * scale;
+            peak = fabsf(sample) > peak ? fabsf(sample) : peak;
+            dst[i * nb_channels + ch] = sample;
+        }
+    }
+    return peak;
+}
+
+void interleave_f32_scalar(float* dst, const float* const* src, int first_frame, int nb_frames, int nb_channels) {
+    for (int ch = 0; ch < nb_channels; ch++) {
+        const float* plane = src[ch];
+        for (int i = first_frame; i < nb_frames; i++) {
+            dst[i * nb_channels + ch] = plane[i];
+        }
+    }
+}
+
+void deinterleave_f32_scalar(float* const* dst, const float* src, int first_frame, int nb_frames, int nb_channels) {
+    for (int ch = 0; ch < nb_channels; ch++) {
+        float* plane = dst[ch];
+        for (int i = first_frame; i < nb_frames; i++) {
+            plane[i] = src[i * nb_channels + ch];
+        }
+    }
+}
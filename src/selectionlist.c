@@ -41,6 +41,8 @@ void selection_list_push_back(SelectionList* list, void* item) {
     }
 
     new_last->data = item;
+    new_last->next = NULL;
+    new_last->prev = NULL;
 
     if (list->last != NULL) {
         list->last->next = new_last;
@@ -63,6 +65,8 @@ void selection_list_push_front(SelectionList* list, void* item) {
     }
 
     newFirst->data = item;
+    newFirst->next = NULL;
+    newFirst->prev = NULL;
 
     if (list->first != NULL) {
         list->first->prev = newFirst;
@@ -80,6 +84,34 @@ void selection_list_push_front(SelectionList* list, void* item) {
 
 }
 
+void* selection_list_pop_front(SelectionList* list) {
+    if (list->length == 0) {
+        return NULL;
+    }
+
+    SelectionListNode* oldFirst = list->first;
+    void* item = oldFirst->data;
+    list->first = oldFirst->next;
+    if (list->first != NULL) {
+        list->first->prev = NULL;
+    } else {
+        list->last = NULL;
+    }
+
+    if (list->current == oldFirst) {
+        list->current = list->first;
+    } else {
+        list->index--;
+    }
+
+    free(oldFirst);
+    list->length -= 1;
+    if (list->length == 0) {
+        list->index = -1;
+    }
+    return item;
+}
+
 void selection_list_clear(SelectionList* list) {
     if (list->length == 0) {
         return;
@@ -117,6 +149,13 @@ void* selection_list_get(SelectionList* list) {
     return NULL;
 }
 
+void* selection_list_peek_front(SelectionList* list) {
+    if (list->length > 0) {
+        return list->first->data;
+    }
+    return NULL;
+}
+
 int selection_list_set_index(SelectionList* list, int new_index) {
     if (new_index >= 0 && new_index < list->length) {
         if (new_index < list->index) {
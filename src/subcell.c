@@ -0,0 +1,144 @@
+#include <subcell.h>
+#include <ncurses.h>
+#include <pthread.h>
+#include <string.h>
+
+typedef uint8_t uchar16 __attribute__((vector_size(16)));
+
+const uint8_t braille_dither_matrix[BRAILLE_DITHER_SIZE][BRAILLE_DITHER_SIZE] = {
+    { 0, 8, 2, 10 },
+    { 12, 4, 14, 6 },
+    { 3, 11, 1, 9 },
+    { 15, 7, 13, 5 }
+};
+const uint8_t braille_left_dots[BRAILLE_CELL_HEIGHT] = { 0x01, 0x02, 0x04, 0x40 };
+const uint8_t braille_right_dots[BRAILLE_CELL_HEIGHT] = { 0x08, 0x10, 0x20, 0x80 };
+
+char braille_glyphs[256][BRAILLE_GLYPH_BYTES];
+pthread_once_t braille_glyphs_built = PTHREAD_ONCE_INIT;
+
+void pixel_data_get_rgb(PixelData* pixelData, int x, int y, rgb output) {
+    if (x < 0 || y < 0 || x >= pixelData->width || y >= pixelData->height) {
+        rgb_set(output, 0, 0, 0);
+    } else if (pixelData->format == RGB24) {
+        const uint8_t* pixel = pixelData->pixels + (y * pixelData->width + x) * 3;
+        rgb_set(output, pixel[0], pixel[1], pixel[2]);
+    } else {
+        const uint8_t value = pixelData->pixels[y * pixelData->width + x];
+        rgb_set(output, value, value, value);
+    }
+}
+
+void print_half_block_image(PixelData* pixelData, int y, int x) {
+    int exhausted = 0;
+    for (int row = 0; row < (pixelData->height + 1) / 2; row++) {
+        move(y + row, x);
+        for (int col = 0; col < pixelData->width; col++) {
+            rgb top, bottom;
+            pixel_data_get_rgb(pixelData, col, row * 2, top);
+            pixel_data_get_rgb(pixelData, col, row * 2 + 1, bottom);
+
+            const int pair = get_lazy_color_pair(get_closest_color(top), get_closest_color(bottom));
+            if (pair >= 0) {
+                color_set(pair, NULL);
+                addstr(HALF_BLOCK_CHARACTER);
+                continue;
+            }
+
+            rgb average;
+            rgb colors[2];
+            rgb_copy(colors[0], top);
+            rgb_copy(colors[1], bottom);
+            get_average_color(average, colors, 2);
+            color_set(get_closest_color_pair(average), NULL);
+            addch(' ');
+            exhausted = 1;
+        }
+    }
+
+    color_set(0, NULL);
+    if (exhausted) {
+        reset_lazy_color_pairs();
+    }
+}
+
+void build_braille_glyphs() {
+    for (int dots = 0; dots < 256; dots++) {
+        const int codepoint = 0x2800 + dots;
+        braille_glyphs[dots][0] = (char)(0xE0 | (codepoint >> 12));
+        braille_glyphs[dots][1] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+        braille_glyphs[dots][2] = (char)(0x80 | (codepoint & 0x3F));
+    }
+}
+
+void braille_threshold_row(const uint8_t* values, int width, int row, int dither, uint8_t* mask) {
+    uint8_t thresholds[sizeof(uchar16)];
+    for (int i = 0; i < (int)sizeof(uchar16); i++) {
+        thresholds[i] = dither ? braille_dither_matrix[row % BRAILLE_DITHER_SIZE][i % BRAILLE_DITHER_SIZE] * 16 + 8 : BRAILLE_THRESHOLD;
+    }
+
+    uchar16 limits;
+    memcpy(&limits, thresholds, sizeof(uchar16));
+    int i = 0;
+    for (; i + (int)sizeof(uchar16) <= width; i += sizeof(uchar16)) {
+        uchar16 block;
+        memcpy(&block, values + i, sizeof(uchar16));
+        uchar16 lit = (uchar16)(block > limits);
+        memcpy(mask + i, &lit, sizeof(uchar16));
+    }
+
+    for (; i < width; i++) {
+        mask[i] = values[i] > thresholds[i % sizeof(uchar16)] ? 0xFF : 0x00;
+    }
+}
+
+void braille_pack_row(const uint8_t* mask, int width, int dot_row, uint8_t* cells) {
+    const uint8_t left = braille_left_dots[dot_row];
+    const uint8_t right = braille_right_dots[dot_row];
+    const int nb_pairs = width / BRAILLE_CELL_WIDTH;
+    for (int c = 0; c < nb_pairs; c++) {
+        cells[c] |= (mask[2 * c] & left) | (mask[2 * c + 1] & right);
+    }
+
+    if (width % BRAILLE_CELL_WIDTH != 0) {
+        cells[nb_pairs] |= mask[width - 1] & left;
+    }
+}
+
+void print_braille_image(PixelData* pixelData, int y, int x, int dither) {
+    pthread_once(&braille_glyphs_built, build_braille_glyphs);
+    const int width = pixelData->width;
+    const int nb_cells = (width + BRAILLE_CELL_WIDTH - 1) / BRAILLE_CELL_WIDTH;
+    uint8_t values[width];
+    uint8_t mask[width];
+    uint8_t cells[nb_cells];
+    char line[nb_cells * BRAILLE_GLYPH_BYTES + 1];
+
+    for (int cell_row = 0; cell_row * BRAILLE_CELL_HEIGHT < pixelData->height; cell_row++) {
+        memset(cells, 0, nb_cells);
+        for (int dot_row = 0; dot_row < BRAILLE_CELL_HEIGHT; dot_row++) {
+            const int row = cell_row * BRAILLE_CELL_HEIGHT + dot_row;
+            if (row >= pixelData->height) {
+                break;
+            }
+
+            const uint8_t* row_values = pixelData->pixels + row * width;
+            if (pixelData->format == RGB24) {
+                const uint8_t* rgb_row = pixelData->pixels + row * width * 3;
+                for (int col = 0; col < width; col++) {
+                    values[col] = get_grayscale(rgb_row[col * 3], rgb_row[col * 3 + 1], rgb_row[col * 3 + 2]);
+                }
+                row_values = values;
+            }
+
+            braille_threshold_row(row_values, width, row, dither, mask);
+            braille_pack_row(mask, width, dot_row, cells);
+        }
+
+        for (int c = 0; c < nb_cells; c++) {
+            memcpy(line + c * BRAILLE_GLYPH_BYTES, braille_glyphs[cells[c]], BRAILLE_GLYPH_BYTES);
+        }
+        line[nb_cells * BRAILLE_GLYPH_BYTES] = '\0';
+        mvaddstr(y + cell_row, x, line);
+    }
+}
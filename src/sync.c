@@ -0,0 +1,173 @@
+#include <sync.h>
+#include <macros.h>
+#include <wtime.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+PlayerState* player_state_alloc() {
+    PlayerState* state = (PlayerState*)malloc(sizeof(PlayerState));
+    if (state == NULL) {
+        fprintf(stderr, "%s\n", "Could not allocate player state");
+        return NULL;
+    }
+
+    pthread_condattr_t cond_attributes;
+    pthread_condattr_init(&cond_attributes);
+    pthread_condattr_setclock(&cond_attributes, CLOCK_MONOTONIC);
+    int error = pthread_cond_init(&state->changed, &cond_attributes);
+    pthread_condattr_destroy(&cond_attributes);
+    if (error) {
+        fprintf(stderr, "%s\n", "Could not initialize player state condition variable");
+        free(state);
+        return NULL;
+    }
+
+    if (pthread_mutex_init(&state->mutex, NULL)) {
+        fprintf(stderr, "%s\n", "Could not initialize player state mutex");
+        pthread_cond_destroy(&state->changed);
+        free(state);
+        return NULL;
+    }
+
+    state->generation = 0;
+    for (int i = 0; i < NUMBER_OF_PLAYER_THREADS; i++) {
+        state->wakeups[i] = 0;
+        state->last_wakeups[i] = 0;
+        state->wakeup_rates[i] = 0.0;
+    }
+    state->last_rate_time = clock_sec();
+    return state;
+}
+
+void player_state_free(PlayerState* state) {
+    pthread_cond_destroy(&state->changed);
+    pthread_mutex_destroy(&state->mutex);
+    free(state);
+}
+
+unsigned long player_state_generation(PlayerState* state) {
+    pthread_mutex_lock(&state->mutex);
+    unsigned long generation = state->generation;
+    pthread_mutex_unlock(&state->mutex);
+    return generation;
+}
+
+void player_state_notify(PlayerState* state) {
+    pthread_mutex_lock(&state->mutex);
+    state->generation++;
+    pthread_cond_broadcast(&state->changed);
+    pthread_mutex_unlock(&state->mutex);
+}
+
+int player_state_wait_forever(PlayerState* state, unsigned long seen_generation) {
+    pthread_mutex_lock(&state->mutex);
+    while (state->generation == seen_generation) {
+        pthread_cond_wait(&state->changed, &state->mutex);
+    }
+    pthread_mutex_unlock(&state->mutex);
+    return 1;
+}
+
+int player_state_wait(PlayerState* state, unsigned long seen_generation, double timeout_seconds) {
+    pthread_mutex_lock(&state->mutex);
+    if (timeout_seconds > 0.0) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        long timeout_nanoseconds = (long)((timeout_seconds - (long)timeout_seconds) * SECONDS_TO_NANOSECONDS);
+        deadline.tv_sec += (long)timeout_seconds + (deadline.tv_nsec + timeout_nanoseconds) / SECONDS_TO_NANOSECONDS;
+        deadline.tv_nsec = (deadline.tv_nsec + timeout_nanoseconds) % SECONDS_TO_NANOSECONDS;
+
+        while (state->generation == seen_generation) {
+            if (pthread_cond_timedwait(&state->changed, &state->mutex, &deadline) == ETIMEDOUT) {
+                break;
+            }
+        }
+    }
+
+    int changed = state->generation != seen_generation;
+    pthread_mutex_unlock(&state->mutex);
+    return changed;
+}
+
+void player_state_count_wakeup(PlayerState* state, PlayerThread thread) {
+    pthread_mutex_lock(&state->mutex);
+    state->wakeups[thread]++;
+    pthread_mutex_unlock(&state->mutex);
+}
+
+void player_state_get_wakeup_rates(PlayerState* state, double* rates) {
+    pthread_mutex_lock(&state->mutex);
+    const double current_time = clock_sec();
+    const double elapsed = current_time - state->last_rate_time;
+    if (elapsed >= 1.0) {
+        for (int i = 0; i < NUMBER_OF_PLAYER_THREADS; i++) {
+            state->wakeup_rates[i] = (state->wakeups[i] - state->last_wakeups[i]) / elapsed;
+            state->last_wakeups[i] = state->wakeups[i];
+        }
+        state->last_rate_time = current_time;
+    }
+
+    for (int i = 0; i < NUMBER_OF_PLAYER_THREADS; i++) {
+        rates[i] = state->wakeup_rates[i];
+    }
+    pthread_mutex_unlock(&state->mutex);
+}
+
+const char* player_thread_name(PlayerThread thread) {
+    switch (thread) {
+        case PLAYER_THREAD_RENDER: return "render";
+        case PLAYER_THREAD_VIDEO: return "video";
+        case PLAYER_THREAD_AUDIO: return "audio";
+        case PLAYER_THREAD_LOADER: return "loader";
+        default: return "unknown";
+    }
+}
+
+int tracked_mutex_init(TrackedMutex* mutex, const char* name) {
+    if (pthread_mutex_init(&mutex->mutex, NULL)) {
+        fprintf(stderr, "%s %s\n", "Could not initialize mutex", name);
+        return 0;
+    }
+
+    mutex->name = name;
+    mutex->acquisitions = 0;
+    mutex->contentions = 0;
+    mutex->wait_time = 0.0;
+    mutex->max_wait_time = 0.0;
+    return 1;
+}
+
+void tracked_mutex_destroy(TrackedMutex* mutex) {
+    pthread_mutex_destroy(&mutex->mutex);
+}
+
+void tracked_mutex_lock(TrackedMutex* mutex) {
+    if (pthread_mutex_trylock(&mutex->mutex) == 0) {
+        mutex->acquisitions++;
+        return;
+    }
+
+    const double wait_start = clock_sec();
+    pthread_mutex_lock(&mutex->mutex);
+    const double waited = clock_sec() - wait_start;
+    mutex->acquisitions++;
+    mutex->contentions++;
+    mutex->wait_time += waited;
+    mutex->max_wait_time = waited > mutex->max_wait_time ? waited : mutex->max_wait_time;
+}
+
+void tracked_mutex_unlock(TrackedMutex* mutex) {
+    pthread_mutex_unlock(&mutex->mutex);
+}
+
+void tracked_mutex_get_stats(TrackedMutex* mutex, TrackedMutexStats* stats) {
+    pthread_mutex_lock(&mutex->mutex);
+    stats->name = mutex->name;
+    stats->acquisitions = mutex->acquisitions;
+    stats->contentions = mutex->contentions;
+    stats->wait_time = mutex->wait_time;
+    stats->max_wait_time = mutex->max_wait_time;
+    pthread_mutex_unlock(&mutex->mutex);
+}
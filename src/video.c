@@ -13,8 +13,9 @@
 #include <macros.h>
 #include <media.h>
 #include <ascii.h>
-#include <loader.h>
+#include <subcell.h>
 #include <wmath.h>
+#include <loader.h>
 
 #include <pthread.h>
 #include <wtime.h>
@@ -30,6 +31,9 @@ const int MAX_FRAME_HEIGHT = 16 * 9;
 const char* debug_video_source = "video";
 const char* debug_video_type = "debug";
 
+VideoConverter* reconfigure_video_converter(VideoConverter* converter, DisplayGeometry* geometry, MediaDebugInfo* debug_info);
+void publish_video_frame(MediaDisplayCache* cache, AVFrame* frame);
+
 void load_image_buffer(MediaPlayer* player, VideoConverter* converter, int amount) {
     const MediaDisplayCache* cache = player->displayCache;
     for (int i = 0; i < amount; i++) {
@@ -43,9 +47,9 @@ void load_image_buffer(MediaPlayer* player, VideoConverter* converter, int amoun
 void* video_playback_thread(void* args) {
     MediaThreadData* thread_data = (MediaThreadData*)args;
     MediaPlayer* player = thread_data->player;
-    pthread_mutex_t* alterMutex = thread_data->alterMutex;
 
     AVFrame* readingFrame = av_frame_alloc();
+    PlayerState* state = player->state;
     Playback* playback = player->timeline->playback;
     MediaDebugInfo* debug_info = player->displayCache->debug_info;
     MediaData* media_data = player->timeline->mediaData;
@@ -63,6 +67,13 @@ void* video_playback_thread(void* args) {
     int output_frame_width, output_frame_height;
     get_output_size(videoCodecContext->width, videoCodecContext->height, MAX_FRAME_WIDTH, MAX_FRAME_HEIGHT, &output_frame_width, &output_frame_height);
 
+    DisplayGeometry geometry;
+    unsigned long seen_geometry = 0;
+    if (read_display_geometry(cache, &seen_geometry, &geometry) && geometry.frame_width > 0 && geometry.frame_height > 0) {
+        output_frame_width = geometry.frame_width;
+        output_frame_height = geometry.frame_height;
+    }
+
     const int use_colors = player->displaySettings->use_colors;
     VideoConverter* videoConverter = get_video_converter(output_frame_width, output_frame_height, use_colors == 1 ? AV_PIX_FMT_RGB24 : AV_PIX_FMT_GRAY8, videoCodecContext->width, videoCodecContext->height, videoCodecContext->pix_fmt);
 
@@ -71,41 +82,56 @@ void* video_playback_thread(void* args) {
         return NULL;
     }
 
+    AVFrame* sourceFrame = NULL;
     SelectionList* videoPackets = video_stream->packets;
-    while (player->inUse && (!media_data->allPacketsRead || (media_data->allPacketsRead && selection_list_can_move_index(videoPackets, 1) ) )) {
-        pthread_mutex_lock(alterMutex);
+    while (player->inUse) {
+        player_state_count_wakeup(state, PLAYER_THREAD_VIDEO);
         /* int64_t targetVideoPTS = get_playback_current_time(playback) * videoTimeBase; */
         /* move_frame_list_to_pts(cache->image_buffer, targetVideoPTS); */
 
         if (get_playback_current_time(playback) >= media_data->duration) {
             player->inUse = 0;
-            pthread_mutex_unlock(alterMutex);
+            player_state_notify(state);
             break;
         } else if (playback->playing == 0) {
-            pthread_mutex_unlock(alterMutex);
-
-            double pauseTime = clock_sec();
-            while (playback->playing == 0) {
-                sleep_for_ms(1);
-                if (!player->inUse) {
-                    return NULL;
+            unsigned long seen_generation = player_state_generation(state);
+            while (playback->playing == 0 && player->inUse) {
+                player_state_wait_forever(state, seen_generation);
+                seen_generation = player_state_generation(state);
+                player_state_count_wakeup(state, PLAYER_THREAD_VIDEO);
+
+                if (read_display_geometry(cache, &seen_geometry, &geometry)) {
+                    videoConverter = reconfigure_video_converter(videoConverter, &geometry, debug_info);
+                    if (sourceFrame != NULL) {
+                        AVFrame* rescaled = convert_video_frame(videoConverter, sourceFrame);
+                        publish_video_frame(cache, rescaled);
+                        av_frame_free(&rescaled);
+                    }
                 }
             }
 
-            pthread_mutex_lock(alterMutex);
-            playback->paused_time += clock_sec() - pauseTime;
+            if (!player->inUse) {
+                break;
+            }
+        }
+
+        tracked_mutex_lock(&video_stream->lock);
+        if (media_data->allPacketsRead && !selection_list_can_move_index(videoPackets, 1)) {
+            tracked_mutex_unlock(&video_stream->lock);
+            break;
         }
 
-        if (selection_list_can_move_index(videoPackets, 10)) {
+        AVFrame* decodedFrame = NULL;
+        if (selection_list_can_move_index(videoPackets, 10) || media_data->allPacketsRead) {
             int decodeResult;
-            int nb_decoded;
+            int nb_decoded = 0;
             AVPacket* currentPacket = (AVPacket*)selection_list_get(videoPackets);
             while (currentPacket == NULL && selection_list_can_move_index(videoPackets, 1)) {
                 selection_list_try_move_index(videoPackets, 1);
                 currentPacket = (AVPacket*)selection_list_get(videoPackets);
             }
             if (currentPacket == NULL) {
-                pthread_mutex_unlock(alterMutex);
+                tracked_mutex_unlock(&video_stream->lock);
                 continue;
             }
 
@@ -116,6 +142,8 @@ void* video_playback_thread(void* args) {
                 repeats++;
                 selection_list_try_move_index(videoPackets, 1);
                 free_frame_list(decodedList, nb_decoded);
+                decodedList = NULL;
+                nb_decoded = 0;
                 currentPacket = (AVPacket*)selection_list_get(videoPackets);
                 while (currentPacket == NULL && selection_list_can_move_index(videoPackets, 1)) {
                     selection_list_try_move_index(videoPackets, 1);
@@ -127,40 +155,48 @@ void* video_playback_thread(void* args) {
 
                 decodedList = decode_video_packet(videoCodecContext, currentPacket, &decodeResult, &nb_decoded);
             }
+            selection_list_try_move_index(videoPackets, 1);
+            tracked_mutex_unlock(&video_stream->lock);
+            wake_loader_if_starved(media_data, video_stream, state);
 
             add_debug_message(debug_info, debug_video_source, debug_video_type, "Number of video packets sent to decoder","Fed %d packets to decode\n", repeats);
 
-            if ((nb_decoded > 0 && decodeResult >= 0) || currentPacket == NULL) {
-                av_frame_free(&readingFrame);
+            if (decodedList != NULL && nb_decoded > 0 && decodeResult >= 0) {
                 add_debug_message(debug_info, debug_video_source, debug_video_type, "Time of decoded video packet","Decoded List Time: %.3f", decodedList[0]->pts * videoTimeBase );
-                readingFrame = convert_video_frame(videoConverter, decodedList[0]);
+                if (read_display_geometry(cache, &seen_geometry, &geometry)) {
+                    videoConverter = reconfigure_video_converter(videoConverter, &geometry, debug_info);
+                }
+                decodedFrame = convert_video_frame(videoConverter, decodedList[0]);
+                av_frame_free(&sourceFrame);
+                sourceFrame = av_frame_clone(decodedList[0]);
                 free_frame_list(decodedList, nb_decoded);
             } else {
+                if (decodedList != NULL) {
+                    free_frame_list(decodedList, nb_decoded);
+                }
                 add_debug_message(debug_info, debug_video_source, debug_video_type, "Null video packet", "ERROR: NULL POINTED VIDEO PACKET: %d", decodeResult);
-                selection_list_try_move_index(videoPackets, 1);
-
-                pthread_mutex_unlock(alterMutex);
                 fsleep_for_sec(1.0 / frameRate);
                 continue;
             }
-
-            selection_list_try_move_index(videoPackets, 1);
         } else {
-            while (!media_data->allPacketsRead && !selection_list_can_move_index(videoPackets, 20)) {
-                fetch_next(media_data, 20);
-            }
-            pthread_mutex_unlock(alterMutex);
+            unsigned long seen_generation = player_state_generation(state);
+            tracked_mutex_unlock(&video_stream->lock);
+            wake_loader_if_starved(media_data, video_stream, state);
+            player_state_wait(state, seen_generation, LOADER_WAIT_MILLISECONDS / (double)SECONDS_TO_MILLISECONDS);
             continue;
         }
 
-        if (player->displayCache->image != NULL) {
-            pixel_data_free(player->displayCache->image);
+        if (decodedFrame == NULL) {
+            continue;
         }
-        player->displayCache->image = pixel_data_alloc_from_frame(readingFrame);
+        av_frame_free(&readingFrame);
+        readingFrame = decodedFrame;
+
+        publish_video_frame(cache, readingFrame);
 
         double nextFrameTimeSinceStartInSeconds = (double)readingFrame->pts * videoTimeBase;
         double frame_speed_skip_time_sec = ( (readingFrame->duration * videoTimeBase) - (readingFrame->duration * videoTimeBase) / playback->speed );
-        playback->skipped_time += frame_speed_skip_time_sec;
+        playback_skip_time(playback, frame_speed_skip_time_sec);
 
         const double current_time = get_playback_current_time(playback);
         double waitDuration = nextFrameTimeSinceStartInSeconds - current_time + (double)(readingFrame->repeat_pict) / (2 * frameRate);
@@ -173,28 +209,123 @@ void* video_playback_thread(void* args) {
             playback->speed, frame_speed_skip_time_sec);
 
 
-        pthread_mutex_unlock(alterMutex);
+        unsigned long seen_generation = player_state_generation(state);
         av_frame_unref(readingFrame);
-        if (waitDuration <= 0) {
+        const double remaining = continueTime - clock_sec();
+        if (remaining <= 0) {
             continue;
         }
-        /* fsleep_for_sec(waitDuration); */
-        while (clock_sec() < continueTime) {
 
-        }
+        player_state_wait(state, seen_generation, remaining);
     }
 
     av_frame_free(&readingFrame);
+    av_frame_free(&sourceFrame);
+    free_video_converter(videoConverter);
     return NULL;
 }
 
+void publish_video_frame(MediaDisplayCache* cache, AVFrame* frame) {
+    PixelData* frameImage = pixel_data_alloc_from_frame(frame);
+    tracked_mutex_lock(&cache->lock);
+    PixelData* replacedImage = cache->image;
+    cache->image = frameImage;
+    tracked_mutex_unlock(&cache->lock);
+    if (replacedImage != NULL) {
+        pixel_data_free(replacedImage);
+    }
+}
+
+VideoConverter* reconfigure_video_converter(VideoConverter* converter, DisplayGeometry* geometry, MediaDebugInfo* debug_info) {
+    const int target_width = geometry->frame_width;
+    const int target_height = geometry->frame_height;
+    if (target_width <= 0 || target_height <= 0 || (target_width == converter->dst_width && target_height == converter->dst_height)) {
+        return converter;
+    }
+
+    VideoConverter* resized = get_video_converter(target_width, target_height, converter->dst_pix_fmt, converter->src_width, converter->src_height, converter->src_pix_fmt);
+    if (resized == NULL) {
+        return converter;
+    }
+
+    add_debug_message(debug_info, debug_video_source, debug_video_type, "Video Scale Target", "Scaling %dx%d to %dx%d for %dx%d cells\n",
+            converter->src_width, converter->src_height, target_width, target_height, geometry->columns, geometry->rows);
+    free_video_converter(converter);
+    return resized;
+}
+
+void get_video_frame_target(int src_width, int src_height, RenderMethod method, int columns, int rows, int* width, int* height) {
+    int cell_width, cell_height;
+    get_terminal_cell_pixel_size(&cell_width, &cell_height);
+
+    int samples_x = 1, samples_y = 1;
+    double max_width = src_width, max_height = src_height;
+    if (method == RENDER_METHOD_HALF_BLOCK) {
+        samples_y = 2;
+    } else if (method == RENDER_METHOD_BRAILLE) {
+        samples_x = BRAILLE_CELL_WIDTH;
+        samples_y = BRAILLE_CELL_HEIGHT;
+    } else if (method == RENDER_METHOD_GRAPHICS) {
+        samples_x = cell_width;
+        samples_y = cell_height;
+        max_width = fmin(max_width, VIDEO_GRAPHICS_MAX_FRAME_WIDTH);
+        max_height = fmin(max_height, VIDEO_GRAPHICS_MAX_FRAME_HEIGHT);
+    }
+
+    const double sample_aspect = ((double)cell_height / samples_y) / ((double)cell_width / samples_x);
+    const double corrected_height = src_height / sample_aspect;
+    double scale = fmin((double)columns * samples_x / src_width, (double)rows * samples_y / corrected_height);
+    scale = fmin(scale, fmin(max_width / src_width, max_height / src_height));
+
+    *width = i32max(1, (int)(src_width * scale + 0.5));
+    *height = i32max(1, (int)(corrected_height * scale + 0.5));
+}
+
+void publish_display_geometry(MediaDisplayCache* cache, DisplayGeometry* geometry) {
+    tracked_mutex_lock(&cache->lock);
+    cache->geometry = *geometry;
+    cache->geometry_generation++;
+    tracked_mutex_unlock(&cache->lock);
+}
+
+int read_display_geometry(MediaDisplayCache* cache, unsigned long* seen_generation, DisplayGeometry* geometry) {
+    if (cache->geometry_generation == *seen_generation) {
+        return 0;
+    }
+
+    tracked_mutex_lock(&cache->lock);
+    *geometry = cache->geometry;
+    *seen_generation = cache->geometry_generation;
+    tracked_mutex_unlock(&cache->lock);
+    return 1;
+}
+
+int media_stream_needs_seek(MediaStream* stream, double targetTime) {
+    tracked_mutex_lock(&stream->lock);
+    const double buffered_start = media_stream_buffered_start_time(stream);
+    const double buffered_end = media_stream_buffered_end_time(stream);
+    const int front_trimmed = stream->front_trimmed;
+    tracked_mutex_unlock(&stream->lock);
+    return (front_trimmed && targetTime - JUMP_KEYFRAME_SEARCH_SECONDS < buffered_start) || targetTime > buffered_end + LOADER_HIGH_WATERMARK_SECONDS;
+}
+
 void jump_to_time(MediaTimeline* timeline, double targetTime) {
     targetTime = fmax(targetTime, 0.0);
     Playback* playback = timeline->playback;
     MediaData* media_data = timeline->mediaData;
     const double originalTime = get_playback_current_time(timeline->playback);
     MediaStream* video_stream = get_media_stream(media_data, AVMEDIA_TYPE_VIDEO);
-    if (video_stream == NULL) {
+    if (video_stream == NULL || media_stream_is_discarded(video_stream)) {
+        MediaStream* audio_stream = get_media_stream(media_data, AVMEDIA_TYPE_AUDIO);
+        if (audio_stream != NULL && !media_stream_is_discarded(audio_stream)) {
+            if (media_stream_needs_seek(audio_stream, targetTime)) {
+                seek_media_data(media_data, targetTime);
+            }
+            if (targetTime > originalTime) {
+                fetch_until(media_data, audio_stream, targetTime);
+            }
+        }
+        playback_skip_time(playback, targetTime - originalTime);
         return;
     }
 
@@ -206,11 +337,22 @@ void jump_to_time(MediaTimeline* timeline, double targetTime) {
 
     if (targetTime == originalTime) {
         return;
-     } else if (targetTime < originalTime || targetTime > originalTime + 60) {
+    }
+
+    const int seeked = media_stream_needs_seek(video_stream, targetTime) && seek_media_data(media_data, targetTime);
+    fetch_until(media_data, video_stream, targetTime);
+    tracked_mutex_lock(&video_stream->lock);
+    if (seeked) {
+        avcodec_flush_buffers(videoCodecContext);
+        selection_list_set_index(videoPackets, 0);
+    } else if (targetTime < originalTime || targetTime > originalTime + 60) {
         avcodec_flush_buffers(videoCodecContext);
-        double testTime = fmax(0.0, targetTime - 30);
+        double testTime = fmax(0.0, targetTime - JUMP_KEYFRAME_SEARCH_SECONDS);
         packet_get = (AVPacket*)selection_list_get(videoPackets);
-        if (packet_get == NULL) { return; }
+        if (packet_get == NULL) {
+            tracked_mutex_unlock(&video_stream->lock);
+            return;
+        }
         double last_time = packet_get->pts * videoTimeBase;
         if (packet_get != NULL) {
             while (selection_list_can_move_index(videoPackets, fsignum(testTime - originalTime))) {
@@ -226,7 +368,7 @@ void jump_to_time(MediaTimeline* timeline, double targetTime) {
                 last_time = packet_get->pts * videoTimeBase;
             }
         }
-     }
+    }
 
     int64_t finalPTS = -1;
     int readingStatus = 0;
@@ -268,7 +410,8 @@ void jump_to_time(MediaTimeline* timeline, double targetTime) {
 
     packet_get = (AVPacket*)selection_list_get(videoPackets);
     finalPTS = finalPTS == -1 && packet_get != NULL ? packet_get->pts : finalPTS;
+    tracked_mutex_unlock(&video_stream->lock);
     double timeMoved = (finalPTS * videoTimeBase) - originalTime;
-    playback->skipped_time += timeMoved;
+    playback_skip_time(playback, timeMoved);
 }
 
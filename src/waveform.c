@@ -0,0 +1,229 @@
+#include <waveform.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WAVEFORM_INITIAL_LEVEL_CAPACITY 256
+
+void waveform_reset_pending(WaveformEnvelope* envelope);
+void waveform_flush_pending(WaveformEnvelope* envelope);
+void waveform_propagate(WaveformEnvelope* envelope, size_t bin_index);
+int waveform_level_reserve(WaveformLevel* level, size_t nb_bins, int nb_channels);
+WaveformBin waveform_bin_merge(WaveformBin first, WaveformBin second);
+
+WaveformEnvelope* waveform_envelope_alloc(int nb_channels, int sample_rate) {
+    WaveformEnvelope* envelope = (WaveformEnvelope*)malloc(sizeof(WaveformEnvelope));
+    if (envelope == NULL) {
+        fprintf(stderr, "%s\n", "Could not allocate waveform envelope");
+        return NULL;
+    }
+
+    envelope->pending_min = (uint8_t*)malloc(sizeof(uint8_t) * nb_channels);
+    envelope->pending_max = (uint8_t*)malloc(sizeof(uint8_t) * nb_channels);
+    envelope->pending_squares = (float*)malloc(sizeof(float) * nb_channels);
+    if (envelope->pending_min == NULL || envelope->pending_max == NULL || envelope->pending_squares == NULL) {
+        fprintf(stderr, "%s\n", "Could not allocate waveform envelope accumulators");
+        free(envelope->pending_min);
+        free(envelope->pending_max);
+        free(envelope->pending_squares);
+        free(envelope);
+        return NULL;
+    }
+
+    for (int i = 0; i < WAVEFORM_MAX_LEVELS; i++) {
+        envelope->levels[i].bins = NULL;
+        envelope->levels[i].nb_bins = 0;
+        envelope->levels[i].capacity = 0;
+    }
+
+    envelope->nb_channels = nb_channels;
+    envelope->sample_rate = sample_rate;
+    envelope->pending_position = 0;
+    waveform_reset_pending(envelope);
+    return envelope;
+}
+
+void waveform_envelope_free(WaveformEnvelope* envelope) {
+    for (int i = 0; i < WAVEFORM_MAX_LEVELS; i++) {
+        free(envelope->levels[i].bins);
+    }
+    free(envelope->pending_min);
+    free(envelope->pending_max);
+    free(envelope->pending_squares);
+    free(envelope);
+}
+
+void waveform_envelope_append(WaveformEnvelope* envelope, size_t position, const uint8_t* samples, size_t nb_samples) {
+    if (envelope->nb_pending > 0 && position != envelope->pending_position) {
+        waveform_flush_pending(envelope);
+    }
+    envelope->pending_position = position;
+
+    const int nb_channels = envelope->nb_channels;
+    for (size_t i = 0; i < nb_samples; i++) {
+        for (int ch = 0; ch < nb_channels; ch++) {
+            const uint8_t sample = samples[i * nb_channels + ch];
+            const float value = ((float)sample - 128.0f) / 128.0f;
+            envelope->pending_min[ch] = sample < envelope->pending_min[ch] ? sample : envelope->pending_min[ch];
+            envelope->pending_max[ch] = sample > envelope->pending_max[ch] ? sample : envelope->pending_max[ch];
+            envelope->pending_squares[ch] += value * value;
+        }
+
+        envelope->nb_pending++;
+        envelope->pending_position++;
+        if (envelope->pending_position % WAVEFORM_BASE_BIN_SAMPLES == 0) {
+            waveform_flush_pending(envelope);
+        }
+    }
+}
+
+int waveform_envelope_query(WaveformEnvelope* envelope, int channel, size_t start_sample, size_t samples_per_column, int nb_columns, WaveformColumn* output) {
+    if (samples_per_column < WAVEFORM_BASE_BIN_SAMPLES) {
+        return 0;
+    }
+
+    int level_index = 0;
+    while (level_index + 1 < WAVEFORM_MAX_LEVELS && ((size_t)WAVEFORM_BASE_BIN_SAMPLES << (level_index + 1)) <= samples_per_column) {
+        level_index++;
+    }
+
+    const WaveformLevel* level = &envelope->levels[level_index];
+    const size_t bin_samples = (size_t)WAVEFORM_BASE_BIN_SAMPLES << level_index;
+    for (int col = 0; col < nb_columns; col++) {
+        const size_t first_bin = (start_sample + col * samples_per_column) / bin_samples;
+        const size_t last_bin = (start_sample + (col + 1) * samples_per_column - 1) / bin_samples;
+        uint8_t min = UINT8_MAX, max = 0;
+        float squares = 0.0f;
+        int nb_filled = 0;
+
+        for (size_t bin_index = first_bin; bin_index <= last_bin && bin_index < level->nb_bins; bin_index++) {
+            const WaveformBin bin = level->bins[bin_index * envelope->nb_channels + channel];
+            if (!bin.filled) {
+                continue;
+            }
+
+            min = bin.min < min ? bin.min : min;
+            max = bin.max > max ? bin.max : max;
+            squares += (bin.rms / 255.0f) * (bin.rms / 255.0f);
+            nb_filled++;
+        }
+
+        output[col].filled = nb_filled > 0;
+        output[col].min = nb_filled > 0 ? ((float)min - 128.0f) / 128.0f : 0.0f;
+        output[col].max = nb_filled > 0 ? ((float)max - 128.0f) / 128.0f : 0.0f;
+        output[col].rms = nb_filled > 0 ? sqrtf(squares / nb_filled) : 0.0f;
+    }
+
+    return nb_columns;
+}
+
+void waveform_columns_from_samples(const uint8_t* samples, size_t nb_samples, int channel, int nb_channels, size_t samples_per_column, int nb_columns, WaveformColumn* output) {
+    for (int col = 0; col < nb_columns; col++) {
+        const size_t start = col * samples_per_column;
+        const size_t end = start + samples_per_column < nb_samples ? start + samples_per_column : nb_samples;
+        float min = 1.0f, max = -1.0f, squares = 0.0f;
+
+        for (size_t i = start; i < end; i++) {
+            const float value = ((float)samples[i * nb_channels + channel] - 128.0f) / 128.0f;
+            min = value < min ? value : min;
+            max = value > max ? value : max;
+            squares += value * value;
+        }
+
+        output[col].filled = end > start;
+        output[col].min = end > start ? min : 0.0f;
+        output[col].max = end > start ? max : 0.0f;
+        output[col].rms = end > start ? sqrtf(squares / (end - start)) : 0.0f;
+    }
+}
+
+void waveform_reset_pending(WaveformEnvelope* envelope) {
+    for (int ch = 0; ch < envelope->nb_channels; ch++) {
+        envelope->pending_min[ch] = UINT8_MAX;
+        envelope->pending_max[ch] = 0;
+        envelope->pending_squares[ch] = 0.0f;
+    }
+    envelope->nb_pending = 0;
+}
+
+void waveform_flush_pending(WaveformEnvelope* envelope) {
+    if (envelope->nb_pending == 0) {
+        return;
+    }
+
+    const int nb_channels = envelope->nb_channels;
+    const size_t bin_index = (envelope->pending_position - 1) / WAVEFORM_BASE_BIN_SAMPLES;
+    WaveformLevel* base = &envelope->levels[0];
+    if (!waveform_level_reserve(base, bin_index + 1, nb_channels)) {
+        waveform_reset_pending(envelope);
+        return;
+    }
+
+    for (int ch = 0; ch < nb_channels; ch++) {
+        const float rms = sqrtf(envelope->pending_squares[ch] / envelope->nb_pending);
+        const WaveformBin pending = { envelope->pending_min[ch], envelope->pending_max[ch], (uint8_t)fminf(255.0f, rms * 255.0f + 0.5f), 1 };
+        base->bins[bin_index * nb_channels + ch] = waveform_bin_merge(base->bins[bin_index * nb_channels + ch], pending);
+    }
+
+    waveform_reset_pending(envelope);
+    waveform_propagate(envelope, bin_index);
+}
+
+void waveform_propagate(WaveformEnvelope* envelope, size_t bin_index) {
+    const int nb_channels = envelope->nb_channels;
+    for (int level_index = 1; level_index < WAVEFORM_MAX_LEVELS; level_index++) {
+        const WaveformLevel* child = &envelope->levels[level_index - 1];
+        WaveformLevel* parent = &envelope->levels[level_index];
+        const size_t parent_index = bin_index / 2;
+        if (!waveform_level_reserve(parent, parent_index + 1, nb_channels)) {
+            return;
+        }
+
+        const size_t left = parent_index * 2, right = parent_index * 2 + 1;
+        for (int ch = 0; ch < nb_channels; ch++) {
+            const WaveformBin empty = { 0, 0, 0, 0 };
+            const WaveformBin left_bin = left < child->nb_bins ? child->bins[left * nb_channels + ch] : empty;
+            const WaveformBin right_bin = right < child->nb_bins ? child->bins[right * nb_channels + ch] : empty;
+            parent->bins[parent_index * nb_channels + ch] = waveform_bin_merge(left_bin, right_bin);
+        }
+        bin_index = parent_index;
+    }
+}
+
+int waveform_level_reserve(WaveformLevel* level, size_t nb_bins, int nb_channels) {
+    if (nb_bins <= level->nb_bins) {
+        return 1;
+    }
+
+    if (nb_bins > level->capacity) {
+        size_t capacity = level->capacity > 0 ? level->capacity : WAVEFORM_INITIAL_LEVEL_CAPACITY;
+        while (capacity < nb_bins) {
+            capacity *= 2;
+        }
+
+        WaveformBin* tmp = (WaveformBin*)realloc(level->bins, sizeof(WaveformBin) * capacity * nb_channels);
+        if (tmp == NULL) {
+            fprintf(stderr, "%s\n", "Could not grow waveform envelope level");
+            return 0;
+        }
+        level->bins = tmp;
+        level->capacity = capacity;
+    }
+
+    memset(level->bins + level->nb_bins * nb_channels, 0, sizeof(WaveformBin) * (nb_bins - level->nb_bins) * nb_channels);
+    level->nb_bins = nb_bins;
+    return 1;
+}
+
+WaveformBin waveform_bin_merge(WaveformBin first, WaveformBin second) {
+    if (!first.filled) {
+        return second;
+    } else if (!second.filled) {
+        return first;
+    }
+
+    const float rms = sqrtf(((float)first.rms * first.rms + (float)second.rms * second.rms) / 2.0f);
+    const WaveformBin merged = { first.min < second.min ? first.min : second.min, first.max > second.max ? first.max : second.max, (uint8_t)fminf(255.0f, rms + 0.5f), 1 };
+    return merged;
+}
@@ -0,0 +1,198 @@
+#include <icons.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/avutil.h>
+#include <libswscale/swscale.h>
+
+#define ICON_ATLAS_THRESHOLD 128
+#define ICON_ATLAS_PATH_SIZE 4096
+
+typedef struct IconSheet {
+    const char* path;
+    int rows;
+    int columns;
+    int sprite_width;
+    int sprite_height;
+    int nb_icons;
+    const char* icon_names[ICONS_SPRITE_ROWS * ICONS_SPRITE_COLUMNS];
+} IconSheet;
+
+const char* video_icon_names[NUMBER_OF_VIDEO_ICONS] = { "STOP_ICON", "PLAY_ICON", "PAUSE_ICON", "FORWARD_ICON", "BACKWARD_ICON", "MUTE_ICON", "NO_VOLUME_ICON", "LOW_VOLUME_ICON", "MEDIUM_VOLUME_ICON", "HIGH_VOLUME_ICON", "MAXIMIZED_ICON", "MINIMIZED_ICON", "ZERO_ICON", "ONE_ICON", "TWO_ICON", "THREE_ICON", "FOUR_ICON", "FIVE_ICON", "SIX_ICON", "SEVEN_ICON", "EIGHT_ICON", "NINE_ICON", "POINT_ICON", "TIMES_ICON", "DIVIDE_ICON", "PLUS_ICON", "MINUS_ICON" };
+
+const IconSheet icon_sheets[] = {
+    { PLAYBACK_ICONS_PATH, ICONS_SPRITE_ROWS, ICONS_SPRITE_COLUMNS, ICONS_SPRITE_WIDTH, ICONS_SPRITE_HEIGHT, 12,
+        { "STOP_ICON", "PLAY_ICON", "FORWARD_ICON", "BACKWARD_ICON", "PAUSE_ICON", "NO_VOLUME_ICON", "LOW_VOLUME_ICON", "MEDIUM_VOLUME_ICON", "HIGH_VOLUME_ICON", "MUTE_ICON", "MAXIMIZED_ICON", "MINIMIZED_ICON" } },
+    { NUMBER_ICONS_PATH, NUMBERS_SPRITE_ROWS, NUMBERS_SPRITE_COLUMNS, NUMBERS_SPRITE_WIDTH, NUMBERS_SPRITE_HEIGHT, 10,
+        { "ZERO_ICON", "ONE_ICON", "TWO_ICON", "THREE_ICON", "FOUR_ICON", "FIVE_ICON", "SIX_ICON", "SEVEN_ICON", "EIGHT_ICON", "NINE_ICON" } },
+    { NUMBER_SYMBOLS_ICONS_PATH, NUMBER_SYMBOLS_SPRITE_ROWS, NUMBER_SYMBOLS_SPRITE_COLUMNS, NUMBER_SYMBOLS_SPRITE_WIDTH, NUMBER_SYMBOLS_SPRITE_HEIGHT, 5,
+        { "POINT_ICON", "TIMES_ICON", "PLUS_ICON", "DIVIDE_ICON", "MINUS_ICON" } },
+};
+const int nb_icon_sheets = sizeof(icon_sheets) / sizeof(IconSheet);
+
+uint8_t* load_grayscale_image(const char* path, int* width, int* height) {
+    AVFormatContext* format_context = NULL;
+    if (avformat_open_input(&format_context, path, NULL, NULL) < 0 || avformat_find_stream_info(format_context, NULL) < 0) {
+        fprintf(stderr, "%s %s\n", "Could not open icon sheet", path);
+        avformat_close_input(&format_context);
+        return NULL;
+    }
+
+    const AVCodec* decoder = NULL;
+    const int stream_index = av_find_best_stream(format_context, AVMEDIA_TYPE_VIDEO, -1, -1, &decoder, 0);
+    AVCodecContext* codec_context = stream_index >= 0 ? avcodec_alloc_context3(decoder) : NULL;
+    if (codec_context == NULL || avcodec_parameters_to_context(codec_context, format_context->streams[stream_index]->codecpar) < 0 || avcodec_open2(codec_context, decoder, NULL) < 0) {
+        fprintf(stderr, "%s %s\n", "Could not open decoder for icon sheet", path);
+        avcodec_free_context(&codec_context);
+        avformat_close_input(&format_context);
+        return NULL;
+    }
+
+    AVPacket* packet = av_packet_alloc();
+    AVFrame* frame = av_frame_alloc();
+    uint8_t* pixels = NULL;
+    int decoded = 0;
+    while (!decoded && av_read_frame(format_context, packet) == 0) {
+        if (packet->stream_index == stream_index && avcodec_send_packet(codec_context, packet) == 0) {
+            decoded = avcodec_receive_frame(codec_context, frame) == 0;
+        }
+        av_packet_unref(packet);
+    }
+
+    if (!decoded && avcodec_send_packet(codec_context, NULL) == 0) {
+        decoded = avcodec_receive_frame(codec_context, frame) == 0;
+    }
+
+    if (decoded) {
+        struct SwsContext* converter = sws_getContext(frame->width, frame->height, frame->format, frame->width, frame->height, AV_PIX_FMT_GRAY8, SWS_POINT, NULL, NULL, NULL);
+        pixels = (uint8_t*)malloc(frame->width * frame->height);
+        if (converter != NULL && pixels != NULL) {
+            uint8_t* destination[4] = { pixels, NULL, NULL, NULL };
+            int destination_linesize[4] = { frame->width, 0, 0, 0 };
+            sws_scale(converter, (const uint8_t* const*)frame->data, frame->linesize, 0, frame->height, destination, destination_linesize);
+            *width = frame->width;
+            *height = frame->height;
+        } else {
+            free(pixels);
+            pixels = NULL;
+        }
+        sws_freeContext(converter);
+    } else {
+        fprintf(stderr, "%s %s\n", "Could not decode icon sheet", path);
+    }
+
+    av_frame_free(&frame);
+    av_packet_free(&packet);
+    avcodec_free_context(&codec_context);
+    avformat_close_input(&format_context);
+    return pixels;
+}
+
+void write_icon_pixels(FILE* output, const char* name, int size_index, const uint8_t* sprite, int sprite_width, int sprite_height, int factor, int* width, int* height) {
+    *width = sprite_width / factor > 0 ? sprite_width / factor : 1;
+    *height = sprite_height / factor > 0 ? sprite_height / factor : 1;
+
+    fprintf(output, "static uint8_t icon_%s_%d[%d] = {", name, size_index, *width * *height);
+    for (int row = 0; row < *height; row++) {
+        fprintf(output, "\n   ");
+        for (int col = 0; col < *width; col++) {
+            int sum = 0, count = 0;
+            for (int y = row * sprite_height / *height; y < (row + 1) * sprite_height / *height; y++) {
+                for (int x = col * sprite_width / *width; x < (col + 1) * sprite_width / *width; x++) {
+                    sum += sprite[y * sprite_width + x];
+                    count++;
+                }
+            }
+            fprintf(output, " %d,", count > 0 && sum / count >= ICON_ATLAS_THRESHOLD ? 255 : 0);
+        }
+    }
+    fprintf(output, "\n};\n");
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        fprintf(stderr, "%s\n", "Usage: icon_atlas <source directory> <output file>");
+        return EXIT_FAILURE;
+    }
+
+    av_log_set_level(AV_LOG_QUIET);
+    FILE* output = fopen(argv[2], "w");
+    if (output == NULL) {
+        fprintf(stderr, "%s %s\n", "Could not open output file", argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    int sizes[NUMBER_OF_VIDEO_ICONS][ICON_ATLAS_NB_SIZES][2];
+    int generated[NUMBER_OF_VIDEO_ICONS];
+    memset(generated, 0, sizeof(generated));
+
+    fprintf(output, "/* Generated by tools/icon_atlas.c from the sprite sheets in assets/. Do not edit. */\n");
+    fprintf(output, "#include <icons.h>\n\n");
+
+    for (int s = 0; s < nb_icon_sheets; s++) {
+        const IconSheet* sheet = &icon_sheets[s];
+        char path[ICON_ATLAS_PATH_SIZE];
+        snprintf(path, ICON_ATLAS_PATH_SIZE, "%s/%s", argv[1], sheet->path);
+
+        int sheet_width, sheet_height;
+        uint8_t* pixels = load_grayscale_image(path, &sheet_width, &sheet_height);
+        if (pixels == NULL) {
+            fclose(output);
+            return EXIT_FAILURE;
+        }
+
+        if (sheet_width < sheet->columns * sheet->sprite_width || sheet_height < sheet->rows * sheet->sprite_height) {
+            fprintf(stderr, "%s %s %dx%d\n", "Icon sheet is smaller than its sprite grid:", path, sheet_width, sheet_height);
+            free(pixels);
+            fclose(output);
+            return EXIT_FAILURE;
+        }
+
+        uint8_t sprite[sheet->sprite_width * sheet->sprite_height];
+        for (int i = 0; i < sheet->nb_icons; i++) {
+            const int sprite_x = i % sheet->columns * sheet->sprite_width;
+            const int sprite_y = i / sheet->columns * sheet->sprite_height;
+            for (int row = 0; row < sheet->sprite_height; row++) {
+                memcpy(sprite + row * sheet->sprite_width, pixels + (sprite_y + row) * sheet_width + sprite_x, sheet->sprite_width);
+            }
+
+            int icon = 0;
+            while (icon < NUMBER_OF_VIDEO_ICONS && strcmp(video_icon_names[icon], sheet->icon_names[i]) != 0) {
+                icon++;
+            }
+
+            for (int size = 0; size < ICON_ATLAS_NB_SIZES; size++) {
+                write_icon_pixels(output, video_icon_names[icon], size, sprite, sheet->sprite_width, sheet->sprite_height, 1 << size, &sizes[icon][size][0], &sizes[icon][size][1]);
+            }
+            generated[icon] = 1;
+        }
+        free(pixels);
+    }
+
+    for (int icon = 0; icon < NUMBER_OF_VIDEO_ICONS; icon++) {
+        if (!generated[icon]) {
+            fprintf(stderr, "%s %s\n", "No sprite sheet provides", video_icon_names[icon]);
+            fclose(output);
+            return EXIT_FAILURE;
+        }
+    }
+
+    fprintf(output, "\nPixelData icon_atlas[NUMBER_OF_VIDEO_ICONS][ICON_ATLAS_NB_SIZES] = {\n");
+    for (int icon = 0; icon < NUMBER_OF_VIDEO_ICONS; icon++) {
+        fprintf(output, "    [%s] = {", video_icon_names[icon]);
+        for (int size = 0; size < ICON_ATLAS_NB_SIZES; size++) {
+            fprintf(output, " { icon_%s_%d, %d, %d, GRAYSCALE8 },", video_icon_names[icon], size, sizes[icon][size][0], sizes[icon][size][1]);
+        }
+        fprintf(output, " },\n");
+    }
+    fprintf(output, "};\n");
+
+    if (fclose(output) != 0) {
+        fprintf(stderr, "%s %s\n", "Could not write output file", argv[2]);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}